@@ -0,0 +1,192 @@
+/*
+**  jstest-gtk - A graphical joystick tester
+**  Copyright (C) 2025 Raphael Rosch <jstest-bugs@insaner.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <string.h>
+
+#include "button_chatter.hpp"
+
+ButtonChatterAnalyzer::ButtonChatterAnalyzer(int button_count, uint32_t bounce_window_ms,
+                                             double chatter_ratio, uint32_t min_bounces) :
+  m_buttons(button_count),
+  m_bounce_window(bounce_window_ms),
+  m_chatter_ratio(chatter_ratio),
+  m_min_bounces(min_bounces)
+{
+  reset();
+}
+
+void
+ButtonChatterAnalyzer::reset()
+{
+  for(auto& stats : m_buttons)
+  {
+    memset(&stats, 0, sizeof(stats));
+    stats.min_interval = UINT32_MAX;
+  }
+}
+
+int
+ButtonChatterAnalyzer::get_bin(uint32_t ms)
+{
+  if (ms == 0)
+    return 0;
+
+  int bin = 32 - __builtin_clz(ms);
+  return bin < histogram_size ? bin : histogram_size - 1;
+}
+
+bool
+ButtonChatterAnalyzer::add(int button, bool pressed, uint32_t time_ms)
+{
+  if (button < 0 || button >= static_cast<int>(m_buttons.size()))
+    return false;
+
+  Stats& stats = m_buttons[button];
+  if (pressed == stats.pressed && stats.has_transition)
+    return false;
+
+  if (stats.has_transition)
+  {
+    uint32_t interval = time_ms - stats.last_transition;
+    stats.intervals[get_bin(interval)] += 1;
+    if (interval < stats.min_interval)
+      stats.min_interval = interval;
+    if (interval < m_bounce_window)
+      stats.bounces += 1;
+
+    if (!pressed && stats.pressed)
+      stats.press_durations[get_bin(time_ms - stats.press_start)] += 1;
+  }
+
+  if (pressed)
+  {
+    stats.presses += 1;
+    stats.press_start = time_ms;
+  }
+
+  stats.pressed = pressed;
+  stats.has_transition = true;
+  stats.last_transition = time_ms;
+
+  bool chattering = stats.bounces >= m_min_bounces &&
+    stats.bounces > m_chatter_ratio * stats.presses;
+  if (chattering != stats.chattering)
+  {
+    stats.chattering = chattering;
+    return true;
+  }
+  return false;
+}
+
+void
+ButtonChatterAnalyzer::resume(int button, bool pressed)
+{
+  if (button < 0 || button >= static_cast<int>(m_buttons.size()))
+    return;
+
+  Stats& stats = m_buttons[button];
+  stats.pressed = pressed;
+  stats.has_transition = false;
+}
+
+#ifdef __TEST__
+
+// g++ -std=c++11 -O2 -D__TEST__ button_chatter.cpp -o button-chatter-test
+
+#include <chrono>
+#include <iostream>
+#include <random>
+
+int main(int argc, char** argv)
+{
+  bool ok = true;
+  std::mt19937 rng(0);
+
+  // 128 buttons, presses of 40-200 ms, button 7 bounces 2-4 ms after
+  // every fourth press and release
+  ButtonChatterAnalyzer analyzer(128);
+  std::uniform_int_distribution<int> hold(40, 200);
+  std::uniform_int_distribution<int> bounce(2, 4);
+  uint32_t t = 0xfffff000; // wraps around during the test
+  for(int press = 0; press < 200; ++press)
+  {
+    for(int button = 0; button < 128; ++button)
+    {
+      analyzer.add(button, true, t);
+      uint32_t release = t + hold(rng);
+      if (button == 7 && press % 4 == 0)
+      {
+        uint32_t b = t + bounce(rng);
+        analyzer.add(button, false, b);
+        analyzer.add(button, true, b + bounce(rng));
+      }
+      analyzer.add(button, false, release);
+      t += 1;
+    }
+    t += 250;
+  }
+
+  const ButtonChatterAnalyzer::Stats& worn = analyzer.get_stats(7);
+  const ButtonChatterAnalyzer::Stats& good = analyzer.get_stats(8);
+  std::cout << "button 7: " << worn.presses << " presses, " << worn.bounces << " bounces, min "
+            << worn.min_interval << " ms, " << (worn.chattering ? "chattering" : "ok") << std::endl;
+  std::cout << "button 8: " << good.presses << " presses, " << good.bounces << " bounces, min "
+            << good.min_interval << " ms, " << (good.chattering ? "chattering" : "ok") << std::endl;
+  std::cout << "press durations of button 8:";
+  for(int i = 0; i < ButtonChatterAnalyzer::histogram_size; ++i)
+    std::cout << " " << ButtonChatterAnalyzer::bin_start(i) << ":" << good.press_durations[i];
+  std::cout << std::endl;
+
+  ok = ok && worn.chattering && !good.chattering;
+  ok = ok && worn.min_interval >= 2 && worn.min_interval <= 4;
+  ok = ok && good.press_durations[6] + good.press_durations[7] + good.press_durations[8] == 200;
+
+  // a reconnect keeps the stats, a button released while the device
+  // was gone isn't taken for a press or a bounce afterwards
+  ButtonChatterAnalyzer::Stats before = worn;
+  analyzer.add(7, true, t);
+  analyzer.resume(7, false);
+  analyzer.add(7, true, t + 1);
+  ok = ok && worn.chattering && worn.presses == before.presses + 2 && worn.bounces == before.bounces;
+
+  // 128 buttons at 1 kHz for a minute, as fast as it goes
+  std::vector<uint8_t> buttons(1 << 16);
+  std::uniform_int_distribution<int> any_button(0, 127);
+  for(auto& button : buttons)
+    button = any_button(rng);
+
+  ButtonChatterAnalyzer busy(128);
+  const int events = 128 * 1000 * 60;
+  auto start = std::chrono::steady_clock::now();
+  int changes = 0;
+  for(int i = 0; i < events; ++i)
+  {
+    int button = buttons[i & 0xffff];
+    changes += busy.add(button, !busy.get_stats(button).pressed, i / 128);
+  }
+  auto end = std::chrono::steady_clock::now();
+  double ns = std::chrono::duration<double, std::nano>(end - start).count() / events;
+  std::cout << "add: " << ns << " ns per event (" << changes << " changes)" << std::endl;
+
+  std::cout << (ok ? "ok" : "WRONG") << std::endl;
+  return ok ? 0 : 1;
+}
+
+#endif
+
+/* EOF */
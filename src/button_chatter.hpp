@@ -0,0 +1,92 @@
+/*
+**  jstest-gtk - A graphical joystick tester
+**  Copyright (C) 2025 Raphael Rosch <jstest-bugs@insaner.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HEADER_JSTEST_GTK_BUTTON_CHATTER_HPP
+#define HEADER_JSTEST_GTK_BUTTON_CHATTER_HPP
+
+#include <stdint.h>
+#include <vector>
+
+/** Collects the timing of every button transition to find worn
+    switches: a transition that follows the previous one of the same
+    button within the bounce window counts as a bounce, and buttons
+    bouncing on too many presses are flagged. Intervals and press
+    durations go into log2 histograms, so memory per button is fixed
+    and an event costs a few comparisons. Times are in milliseconds,
+    like the joydev event time, and may wrap. */
+class ButtonChatterAnalyzer
+{
+public:
+  // bin 0 is 0 ms, bin i covers [2^(i-1), 2^i) ms, the last bin
+  // everything above
+  static const int histogram_size = 16;
+
+  struct Stats
+  {
+    bool pressed;
+    bool has_transition;
+    uint32_t last_transition;
+    uint32_t press_start;
+
+    uint32_t presses;
+    uint32_t bounces;
+    uint32_t min_interval; // shortest time between two transitions
+
+    uint32_t intervals[histogram_size];
+    uint32_t press_durations[histogram_size];
+
+    bool chattering;
+  };
+
+private:
+  std::vector<Stats> m_buttons;
+  uint32_t m_bounce_window;
+  double m_chatter_ratio;
+  uint32_t m_min_bounces;
+
+public:
+  /** Buttons bouncing within \a bounce_window_ms on more than
+      \a chatter_ratio of their presses, and at least \a min_bounces
+      times, are flagged */
+  ButtonChatterAnalyzer(int button_count, uint32_t bounce_window_ms = 10,
+                        double chatter_ratio = 0.05, uint32_t min_bounces = 3);
+
+  /** Returns true when the button got flagged or unflagged */
+  bool add(int button, bool pressed, uint32_t time_ms);
+
+  /** Takes \a pressed as the state of \a button without counting a
+      transition, for the initial state joydev reports when the device
+      is opened again. What was collected so far is kept, the next
+      transition isn't timed against the ones before the gap. */
+  void resume(int button, bool pressed);
+
+  void reset();
+
+  const Stats& get_stats(int button) const { return m_buttons[button]; }
+  int get_button_count() const { return static_cast<int>(m_buttons.size()); }
+
+  /** Lower end of histogram bin \a i in milliseconds */
+  static uint32_t bin_start(int i) { return i == 0 ? 0 : (1u << (i - 1)); }
+
+private:
+  static int get_bin(uint32_t ms);
+};
+
+#endif
+
+/* EOF */
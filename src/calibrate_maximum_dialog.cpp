@@ -16,38 +16,187 @@
 **  along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <algorithm>
 #include <iostream>
+#include <sstream>
+#include <glibmm/main.h>
 #include <gtkmm/stock.h>
 
 #include "joystick.hpp"
 #include "calibrate_maximum_dialog.hpp"
-
+#include "verbose.hpp"
+
+namespace {
+
+// how long the axes are left alone to measure their noise
+const int rest_duration_ms = 2000;
+const int sample_interval_ms = 10;
+
+} // namespace
+
 CalibrateMaximumDialog::CalibrateMaximumDialog(Joystick& joystick_)
   : Gtk::Dialog("CalibrationWizard: " + joystick_.get_name()),
     joystick(joystick_),
     orig_data(joystick.get_calibration()),
-    label("1) Rotate your joystick around to move all axis into their extreme positions at least once\n"
-          "2) Move all axis back to the center\n"
-          "3) Press ok\n")
+    label(),
+    rest_progress(),
+    rest_button("Measure rest again"),
+    axis_table(joystick.get_axis_count() + 1, 5),
+    connection(),
+    sample_timeout(),
+    measuring_rest(false),
+    rest_start(0),
+    sample_count(0),
+    rest_histograms(joystick.get_axis_count()),
+    range_histograms(joystick.get_axis_count()),
+    range_labels(),
+    center_labels(),
+    confidence_bars()
 {
   joystick.clear_calibration();
 
   set_border_width(5);
   label.set_line_wrap();
-  get_vbox()->add(label);
+  get_vbox()->set_spacing(5);
+  get_vbox()->pack_start(label, Gtk::PACK_SHRINK);
+  get_vbox()->pack_start(rest_progress, Gtk::PACK_SHRINK);
+
+  axis_table.set_spacings(5);
+  axis_table.attach(*Gtk::manage(new Gtk::Label("Axes")), 0, 1, 0, 1);
+  axis_table.attach(*Gtk::manage(new Gtk::Label("Range")), 1, 2, 0, 1);
+  axis_table.attach(*Gtk::manage(new Gtk::Label("Center")), 2, 3, 0, 1);
+  axis_table.attach(*Gtk::manage(new Gtk::Label("Confidence")), 3, 4, 0, 1);
+
+  for(int i = 0; i < joystick.get_axis_count(); ++i)
+  {
+    std::ostringstream str;
+    str << "Axis " << i;
+    axis_table.attach(*Gtk::manage(new Gtk::Label(str.str())), 0, 1, i+1, i+2);
+
+    range_labels.push_back(Gtk::manage(new Gtk::Label()));
+    center_labels.push_back(Gtk::manage(new Gtk::Label()));
+    confidence_bars.push_back(Gtk::manage(new Gtk::ProgressBar()));
+    confidence_bars.back()->set_show_text(true);
+
+    axis_table.attach(*range_labels.back(), 1, 2, i+1, i+2);
+    axis_table.attach(*center_labels.back(), 2, 3, i+1, i+2);
+    axis_table.attach(*confidence_bars.back(), 3, 4, i+1, i+2, Gtk::FILL|Gtk::EXPAND, Gtk::EXPAND);
+
+    Gtk::Button& retry = *Gtk::manage(new Gtk::Button("Retry"));
+    retry.signal_clicked().connect(sigc::bind(sigc::mem_fun(this, &CalibrateMaximumDialog::on_retry), i));
+    axis_table.attach(retry, 4, 5, i+1, i+2, Gtk::SHRINK, Gtk::SHRINK);
+  }
+
+  get_vbox()->pack_start(axis_table, Gtk::PACK_EXPAND_WIDGET);
+  get_vbox()->pack_start(rest_button, Gtk::PACK_SHRINK);
+  // run() returns on any response, so this one is a plain button
+  rest_button.signal_clicked().connect(sigc::mem_fun(this, &CalibrateMaximumDialog::start_rest));
+
   add_button(Gtk::Stock::CANCEL, 1);
   add_button(Gtk::Stock::OK, 0);
 
   connection = joystick.axis_move.connect(sigc::mem_fun(this, &CalibrateMaximumDialog::on_axis_move));
+  // joydev only reports changes, sampling the state as well weights
+  // positions by the time they were held
+  sample_timeout = Glib::signal_timeout().connect(sigc::mem_fun(this, &CalibrateMaximumDialog::on_sample),
+                                                  sample_interval_ms);
+
+  start_rest();
+}
+
+CalibrateMaximumDialog::~CalibrateMaximumDialog()
+{
+  connection.disconnect();
+  sample_timeout.disconnect();
+}
+
+void
+CalibrateMaximumDialog::start_rest()
+{
+  for(auto& histogram : rest_histograms)
+  {
+    histogram.clear();
+  }
+
+  measuring_rest = true;
+  rest_start = g_get_monotonic_time();
+  rest_button.set_sensitive(false);
+  label.set_text("Measuring the resting noise, don't touch the joystick...");
+  update_results();
+}
+
+void
+CalibrateMaximumDialog::on_retry(int axis)
+{
+  range_histograms[axis].clear();
+  update_results();
+}
 
-  is_init_axis_state.resize(joystick.get_axis_count(), false);
-  min_axis_state.resize(joystick.get_axis_count());
-  max_axis_state.resize(joystick.get_axis_count());
+bool
+CalibrateMaximumDialog::on_sample()
+{
+  for(int i = 0; i < joystick.get_axis_count(); ++i)
+  {
+    on_axis_move(i, joystick.get_axis_state(i));
+  }
 
+  if (measuring_rest)
+  {
+    gint64 elapsed_ms = (g_get_monotonic_time() - rest_start) / 1000;
+    rest_progress.set_fraction(std::min(1.0, elapsed_ms / static_cast<double>(rest_duration_ms)));
+    if (elapsed_ms >= rest_duration_ms)
+    {
+      measuring_rest = false;
+      rest_button.set_sensitive(true);
+      label.set_text("1) Rotate your joystick around to move all axis into their extreme positions\n"
+                     "   and hold them there for a moment\n"
+                     "2) Press Retry on axes with a low confidence and move them again\n"
+                     "3) Press ok\n");
+    }
+  }
+
+  sample_count += 1;
+  if (sample_count % 10 == 0)
+  {
+    update_results();
+  }
+
+  return true;
+}
+
+void
+CalibrateMaximumDialog::update_results()
+{
   for(int i = 0; i < joystick.get_axis_count(); ++i)
   {
-    min_axis_state[i] = joystick.get_axis_state(i);
-    max_axis_state[i] = joystick.get_axis_state(i);
+    if (measuring_rest || range_histograms[i].count() == 0)
+    {
+      range_labels[i]->set_text("-");
+      center_labels[i]->set_text("-");
+      confidence_bars[i]->set_fraction(0.0);
+      confidence_bars[i]->set_text(measuring_rest ? "resting" : "not moved");
+    }
+    else
+    {
+      AxisCalibrationEstimate estimate = estimate_axis_calibration(rest_histograms[i], range_histograms[i]);
+
+      std::ostringstream range;
+      range << estimate.range_min << " .. " << estimate.range_max;
+      range_labels[i]->set_text(range.str());
+
+      std::ostringstream center;
+      center << estimate.center_min << " .. " << estimate.center_max;
+      center_labels[i]->set_text(center.str());
+
+      std::ostringstream confidence;
+      confidence << static_cast<int>(estimate.confidence * 100) << "%";
+      if (!estimate.problem.empty())
+      {
+        confidence << " " << estimate.problem;
+      }
+      confidence_bars[i]->set_fraction(estimate.confidence);
+      confidence_bars[i]->set_text(confidence.str());
+    }
   }
 }
 
@@ -61,21 +210,17 @@ CalibrateMaximumDialog::on_response(int v)
 
     for(int i = 0; i < joystick.get_axis_count(); ++i)
     {
+      AxisCalibrationEstimate estimate = estimate_axis_calibration(rest_histograms[i], range_histograms[i]);
+      m_verbose and std::cout << "axis " << i << ": confidence " << estimate.confidence
+                              << " " << estimate.problem << std::endl;
+
       Joystick::CalibrationData axis;
       axis.calibrate  = true;
       axis.invert     = false;
-      axis.center_min = axis.center_max = joystick.get_axis_state(i);
-      axis.range_min  = min_axis_state[i];
-      axis.range_max  = max_axis_state[i];
-
-      // When the center is the same as the outer edge of an axis,
-      // we assume its a throttle control or analog button and
-      // calculate the center on our own
-      if (axis.center_min == axis.range_min ||
-          axis.center_max == axis.range_max)
-      {
-        axis.center_min = axis.center_max = (axis.range_min + axis.range_max)/2;
-      }
+      axis.center_min = estimate.center_min;
+      axis.center_max = estimate.center_max;
+      axis.range_min  = estimate.range_min;
+      axis.range_max  = estimate.range_max;
 
       data.push_back(axis);
     }
@@ -93,18 +238,17 @@ CalibrateMaximumDialog::on_response(int v)
 void
 CalibrateMaximumDialog::on_axis_move(int id, int value)
 {
-  // std::cout << "AxisMove: " << id << " " << value << std::endl;
-  if (!is_init_axis_state[id])
+  if (id < 0 || id >= joystick.get_axis_count())
+    return;
+
+  if (measuring_rest)
   {
-    min_axis_state[id] = value;
-    max_axis_state[id] = value;
-    is_init_axis_state[id] = true;
+    rest_histograms[id].add(value);
   }
   else
   {
-    min_axis_state[id] = std::min(value, min_axis_state[id]);
-    max_axis_state[id] = std::max(value, max_axis_state[id]);
+    range_histograms[id].add(value);
   }
 }
-
+
 /* EOF */
@@ -19,28 +19,56 @@
 #ifndef HEADER_JSTEST_GTK_CALIBRATE_MAXIMUM_DIALOG_HPP
 #define HEADER_JSTEST_GTK_CALIBRATE_MAXIMUM_DIALOG_HPP
 
+#include <gtkmm/button.h>
 #include <gtkmm/dialog.h>
 #include <gtkmm/label.h>
+#include <gtkmm/progressbar.h>
+#include <gtkmm/table.h>
+
+#include "streaming_histogram.hpp"
 
 class Joystick;
 
+/** Measures the resting noise of all axes for a moment, then collects
+    a histogram of each axis while the user moves them around. The
+    range comes from robust percentiles and the deadzone from the noise
+    band, each axis gets a confidence and can be redone on its own. */
 class CalibrateMaximumDialog : public Gtk::Dialog
 {
 private:
   Joystick& joystick;
   std::vector<Joystick::CalibrationData> orig_data;
   Gtk::Label label;
+  Gtk::ProgressBar rest_progress;
+  Gtk::Button rest_button;
+  Gtk::Table axis_table;
   sigc::connection connection;
-  std::vector<bool> is_init_axis_state;
-  std::vector<int> min_axis_state;
-  std::vector<int> max_axis_state;
+  sigc::connection sample_timeout;
+
+  bool measuring_rest;
+  gint64 rest_start;
+  int sample_count;
+
+  std::vector<StreamingHistogram> rest_histograms;
+  std::vector<StreamingHistogram> range_histograms;
+
+  std::vector<Gtk::Label*> range_labels;
+  std::vector<Gtk::Label*> center_labels;
+  std::vector<Gtk::ProgressBar*> confidence_bars;
 
 public:
   CalibrateMaximumDialog(Joystick& joystick);
+  ~CalibrateMaximumDialog();
 
   void on_response(int v) override;
   void on_axis_move(int id, int value);
 
+private:
+  void start_rest();
+  void on_retry(int axis);
+  bool on_sample();
+  void update_results();
+
 private:
   CalibrateMaximumDialog(const CalibrateMaximumDialog&);
   CalibrateMaximumDialog& operator=(const CalibrateMaximumDialog&);
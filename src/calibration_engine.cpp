@@ -0,0 +1,474 @@
+/*
+**  jstest-gtk - A graphical joystick tester
+**  Copyright (C) 2025 Raphael Rosch <jstest-bugs@insaner.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+
+#include "calibration_engine.hpp"
+
+namespace {
+
+// The kernel multiplies in int and relies on -fno-strict-overflow,
+// a coef of 1<<29 times a difference above 3 wraps around. Multiply
+// as unsigned to get the same bits without undefined behaviour.
+inline int32_t wrapping_mul(int32_t a, int32_t b)
+{
+  return static_cast<int32_t>(static_cast<uint32_t>(a) * static_cast<uint32_t>(b));
+}
+
+inline int32_t wrapping_sub(int32_t a, int32_t b)
+{
+  return static_cast<int32_t>(static_cast<uint32_t>(a) - static_cast<uint32_t>(b));
+}
+
+// the kernel shifts, which rounds towards minus infinity, where a
+// division by 16384 as in the old jscal notes would round towards 0
+inline int32_t correct_one(int32_t type, int32_t center_min, int32_t center_max,
+                           int32_t slope_min, int32_t slope_max, int32_t value)
+{
+  int32_t below = wrapping_mul(slope_min, wrapping_sub(value, center_min)) >> 14;
+  int32_t above = wrapping_mul(slope_max, wrapping_sub(value, center_max)) >> 14;
+  int32_t broken = value > center_min ? (value < center_max ? 0 : above) : below;
+
+  int32_t result = (type == JS_CORR_NONE) ? value : (type == JS_CORR_BROKEN ? broken : 0);
+  return std::min(std::max(result, -32767), 32767);
+}
+
+} // namespace
+
+int joydev_correct(int value, const struct js_corr& corr)
+{
+  switch (corr.type)
+  {
+    case JS_CORR_NONE:
+      break;
+
+    case JS_CORR_BROKEN:
+      value = value > corr.coef[0] ? (value < corr.coef[1] ? 0 :
+                                      (wrapping_mul(corr.coef[3], wrapping_sub(value, corr.coef[1])) >> 14)) :
+        (wrapping_mul(corr.coef[2], wrapping_sub(value, corr.coef[0])) >> 14);
+      break;
+
+    default:
+      return 0;
+  }
+
+  return value < -32767 ? -32767 : (value > 32767 ? 32767 : value);
+}
+
+bool corr_equal(const std::vector<struct js_corr>& lhs, const std::vector<struct js_corr>& rhs)
+{
+  if (lhs.size() != rhs.size())
+    return false;
+
+  for(size_t i = 0; i < lhs.size(); ++i)
+  {
+    if (lhs[i].type != rhs[i].type ||
+        lhs[i].prec != rhs[i].prec ||
+        !std::equal(lhs[i].coef, lhs[i].coef + 8, rhs[i].coef))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool permute_calibration(const std::vector<struct js_corr>& corr,
+                         const std::vector<int>& mapping_old,
+                         const std::vector<int>& mapping_new,
+                         std::vector<struct js_corr>& out)
+{
+  if (corr.size() != mapping_old.size() || mapping_new.size() != mapping_old.size())
+    return false;
+
+  // old axis index by ABS_* code, -1 for codes that aren't mapped or
+  // were already taken by mapping_new
+  int index[ABS_MAX + 1];
+  std::fill(index, index + ABS_MAX + 1, -1);
+  for(size_t i = 0; i < mapping_old.size(); ++i)
+  {
+    int code = mapping_old[i];
+    if (code < 0 || code > ABS_MAX || index[code] != -1)
+      return false;
+    index[code] = static_cast<int>(i);
+  }
+
+  std::vector<struct js_corr> result(mapping_new.size());
+  for(size_t i = 0; i < mapping_new.size(); ++i)
+  {
+    int code = mapping_new[i];
+    if (code < 0 || code > ABS_MAX || index[code] == -1)
+      return false;
+    result[i] = corr[index[code]];
+    index[code] = -1;
+  }
+
+  out.swap(result);
+  return true;
+}
+
+RemapResult write_remap(const std::vector<struct js_corr>& corr,
+                        std::vector<int> mapping_old,
+                        const std::vector<int>& mapping_new,
+                        const std::function<void (const std::vector<int>&)>& write_mapping,
+                        const std::function<void (const std::vector<struct js_corr>&)>& write_corr)
+{
+  if (mapping_new == mapping_old)
+    return REMAP_UNCHANGED;
+
+  std::vector<struct js_corr> corr_new;
+  if (!permute_calibration(corr, mapping_old, mapping_new, corr_new))
+    return REMAP_INVALID;
+
+  write_mapping(mapping_new);
+  try
+  {
+    write_corr(corr_new);
+  }
+  catch(...)
+  {
+    try
+    {
+      write_mapping(mapping_old);
+    }
+    catch(...)
+    {
+      // the error of the calibration is the one to report
+    }
+    throw;
+  }
+
+  return REMAP_WRITTEN;
+}
+
+CalibrationEngine::CalibrationEngine() :
+  m_type(),
+  m_center_min(),
+  m_center_max(),
+  m_slope_min(),
+  m_slope_max()
+{
+}
+
+CalibrationEngine::CalibrationEngine(const std::vector<struct js_corr>& corr) :
+  m_type(),
+  m_center_min(),
+  m_center_max(),
+  m_slope_min(),
+  m_slope_max()
+{
+  set(corr);
+}
+
+void
+CalibrationEngine::set(const std::vector<struct js_corr>& corr)
+{
+  m_type.resize(corr.size());
+  m_center_min.resize(corr.size());
+  m_center_max.resize(corr.size());
+  m_slope_min.resize(corr.size());
+  m_slope_max.resize(corr.size());
+
+  for(size_t i = 0; i < corr.size(); ++i)
+  {
+    m_type[i]       = corr[i].type;
+    m_center_min[i] = corr[i].coef[0];
+    m_center_max[i] = corr[i].coef[1];
+    m_slope_min[i]  = corr[i].coef[2];
+    m_slope_max[i]  = corr[i].coef[3];
+  }
+}
+
+int
+CalibrationEngine::correct(size_t axis, int value) const
+{
+  return correct_one(m_type[axis], m_center_min[axis], m_center_max[axis],
+                     m_slope_min[axis], m_slope_max[axis], value);
+}
+
+void
+CalibrationEngine::correct_all(const int* __restrict raw, int* __restrict out) const
+{
+  // without __restrict gcc has to assume that out overlaps the
+  // coefficients and adds a runtime check to the vectorized loop
+  const int32_t* __restrict type       = m_type.data();
+  const int32_t* __restrict center_min = m_center_min.data();
+  const int32_t* __restrict center_max = m_center_max.data();
+  const int32_t* __restrict slope_min  = m_slope_min.data();
+  const int32_t* __restrict slope_max  = m_slope_max.data();
+
+  const size_t count = m_type.size();
+  for(size_t i = 0; i < count; ++i)
+  {
+    out[i] = correct_one(type[i], center_min[i], center_max[i], slope_min[i], slope_max[i], raw[i]);
+  }
+}
+
+#ifdef __TEST__
+
+// g++ -std=c++11 -O3 -fwrapv -D__TEST__ calibration_engine.cpp -o calibration-engine-test
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+// literal copy of the kernel function, which is built with
+// -fno-strict-overflow, hence -fwrapv for this test
+int kernel_joydev_correct(int value, const struct js_corr* corr)
+{
+  switch (corr->type) {
+  case JS_CORR_NONE:
+    break;
+  case JS_CORR_BROKEN:
+    value = value > corr->coef[0] ? (value < corr->coef[1] ? 0 :
+            ((corr->coef[3] * (value - corr->coef[1])) >> 14)) :
+      ((corr->coef[2] * (value - corr->coef[0])) >> 14);
+    break;
+  default:
+    return 0;
+  }
+
+  return value < -32767 ? -32767 : (value > 32767 ? 32767 : value);
+}
+
+struct js_corr make_corr(int type, int c0, int c1, int c2, int c3)
+{
+  struct js_corr corr;
+  corr.type = type;
+  corr.prec = 0;
+  std::fill(corr.coef, corr.coef + 8, 0);
+  corr.coef[0] = c0;
+  corr.coef[1] = c1;
+  corr.coef[2] = c2;
+  corr.coef[3] = c3;
+  return corr;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  std::vector<struct js_corr> corrs = {
+    make_corr(JS_CORR_NONE, 0, 0, 0, 0),
+    make_corr(JS_CORR_BROKEN, 0, 0, 536870912, 536870912),    // 1<<29, wraps for |value| > 3
+    make_corr(JS_CORR_BROKEN, -15, 15, 5534751, 5534751),     // from jscal -p
+    make_corr(JS_CORR_BROKEN, 112, 142, 5534751, 5534751),
+    make_corr(JS_CORR_BROKEN, 127, 128, 4227201, 4260750),    // 0..255 axis
+    make_corr(JS_CORR_BROKEN, 0, 0, -16384, -16384),          // inverted
+    make_corr(JS_CORR_BROKEN, 500, -500, 16384, 16384),       // center_max below center_min
+    make_corr(2, 0, 0, 16384, 16384),                         // unknown type
+  };
+
+  std::mt19937 rng(0);
+  std::uniform_int_distribution<int> coef(-(1 << 30), 1 << 30);
+  std::uniform_int_distribution<int> center(-32768, 32767);
+  for(int i = 0; i < 56; ++i)
+  {
+    int c0 = center(rng);
+    int c1 = center(rng);
+    corrs.push_back(make_corr(JS_CORR_BROKEN, std::min(c0, c1), std::max(c0, c1), coef(rng), coef(rng)));
+  }
+
+  CalibrationEngine engine(corrs);
+
+  // every int16 value on every axis at once, plus the scalar paths
+  long mismatches = 0;
+  std::vector<int> raw(corrs.size());
+  std::vector<int> out(corrs.size());
+  for(int value = -32768; value <= 32767; ++value)
+  {
+    std::fill(raw.begin(), raw.end(), value);
+    engine.correct_all(raw.data(), out.data());
+    for(size_t axis = 0; axis < corrs.size(); ++axis)
+    {
+      int expected = kernel_joydev_correct(value, &corrs[axis]);
+      if (out[axis] != expected ||
+          engine.correct(axis, value) != expected ||
+          joydev_correct(value, corrs[axis]) != expected)
+      {
+        if (mismatches++ < 10)
+          std::cout << "axis " << axis << " value " << value << ": got " << out[axis]
+                    << ", kernel " << expected << std::endl;
+      }
+    }
+  }
+
+  // the calibration has to follow its ABS_* code through any chain of
+  // remaps, tag every js_corr with the code it was made for
+  long permute_errors = 0;
+  for(int run = 0; run < 1000; ++run)
+  {
+    std::vector<int> codes(ABS_MAX + 1);
+    for(int code = 0; code <= ABS_MAX; ++code)
+      codes[code] = code;
+    std::shuffle(codes.begin(), codes.end(), rng);
+    codes.resize(1 + run % 32);
+
+    std::vector<int> mapping = codes;
+    std::vector<struct js_corr> corr;
+    for(int code : mapping)
+      corr.push_back(make_corr(JS_CORR_BROKEN, code, code, 16384, 16384));
+    const std::vector<struct js_corr> first_corr = corr;
+    const std::vector<int> first_mapping = mapping;
+
+    for(int step = 0; step < 8; ++step)
+    {
+      std::vector<int> next = mapping;
+      std::shuffle(next.begin(), next.end(), rng);
+      if (!permute_calibration(corr, mapping, next, corr))
+        permute_errors += 1;
+      mapping = next;
+
+      for(size_t i = 0; i < mapping.size(); ++i)
+      {
+        if (corr[i].coef[0] != mapping[i])
+          permute_errors += 1;
+      }
+    }
+
+    // a single remap from the start gives the same as the chain
+    std::vector<struct js_corr> direct;
+    if (!permute_calibration(first_corr, first_mapping, mapping, direct) || !corr_equal(direct, corr))
+      permute_errors += 1;
+
+    // invalid maps are refused without touching the output
+    std::vector<int> duplicate = mapping;
+    duplicate[0] = duplicate.back();
+    std::vector<int> foreign = mapping;
+    foreign[run % foreign.size()] = ABS_MAX + 1;
+    std::vector<int> shorter(mapping.begin(), mapping.end() - 1);
+    std::vector<struct js_corr> untouched = corr;
+    if ((duplicate.size() > 1 && permute_calibration(corr, mapping, duplicate, untouched)) ||
+        permute_calibration(corr, mapping, foreign, untouched) ||
+        permute_calibration(corr, mapping, shorter, untouched) ||
+        !corr_equal(untouched, corr))
+    {
+      permute_errors += 1;
+    }
+  }
+
+  // write_remap() against a fake device that logs its writes and can
+  // be told to fail them
+  long remap_errors = 0;
+  {
+    std::vector<int> dev_mapping = { ABS_X, ABS_Y, ABS_Z };
+    std::vector<struct js_corr> dev_corr;
+    for(int code : dev_mapping)
+      dev_corr.push_back(make_corr(JS_CORR_BROKEN, code, code, 16384, 16384));
+    std::string log;
+    bool fail_rollback = false;
+    bool fail_corr = false;
+    auto write_mapping = [&](const std::vector<int>& m) {
+      bool rollback = !log.empty() && log.back() == 'c';
+      log += "m";
+      if (fail_rollback && rollback) throw std::runtime_error("rollback");
+      dev_mapping = m;
+    };
+    auto write_corr = [&](const std::vector<struct js_corr>& c) {
+      log += "c";
+      if (fail_corr) throw std::runtime_error("corr");
+      dev_corr = c;
+    };
+    const std::vector<int> start_mapping = dev_mapping;
+    const std::vector<struct js_corr> start_corr = dev_corr;
+    const std::vector<int> swapped = { ABS_Y, ABS_X, ABS_Z };
+
+    // unchanged and invalid maps write nothing
+    if (write_remap(dev_corr, dev_mapping, start_mapping, write_mapping, write_corr) != REMAP_UNCHANGED ||
+        write_remap(dev_corr, dev_mapping, { ABS_X, ABS_X, ABS_Z }, write_mapping, write_corr) != REMAP_INVALID ||
+        !log.empty())
+    {
+      remap_errors += 1;
+    }
+
+    // the map goes first, the calibration follows its axes
+    if (write_remap(dev_corr, dev_mapping, swapped, write_mapping, write_corr) != REMAP_WRITTEN ||
+        log != "mc" || dev_mapping != swapped ||
+        dev_corr[0].coef[0] != ABS_Y || dev_corr[1].coef[0] != ABS_X || dev_corr[2].coef[0] != ABS_Z)
+    {
+      remap_errors += 1;
+    }
+
+    // a failed calibration write puts the old map back and is passed on
+    const std::vector<struct js_corr> swapped_corr = dev_corr;
+    log.clear();
+    fail_corr = true;
+    std::string error;
+    try
+    {
+      write_remap(dev_corr, dev_mapping, start_mapping, write_mapping, write_corr);
+    }
+    catch(const std::exception& err)
+    {
+      error = err.what();
+    }
+    if (error != "corr" || log != "mcm" || dev_mapping != swapped || !corr_equal(dev_corr, swapped_corr))
+      remap_errors += 1;
+
+    // when the rollback fails as well, the calibration error is reported
+    log.clear();
+    error.clear();
+    fail_rollback = true;
+    try
+    {
+      write_remap(dev_corr, dev_mapping, start_mapping, write_mapping, write_corr);
+    }
+    catch(const std::exception& err)
+    {
+      error = err.what();
+    }
+    if (error != "corr" || log != "mcm" || dev_mapping != start_mapping)
+      remap_errors += 1;
+
+    log.clear();
+    fail_rollback = false;
+    fail_corr = false;
+    dev_mapping = swapped;
+    if (write_remap(dev_corr, dev_mapping, start_mapping, write_mapping, write_corr) != REMAP_WRITTEN ||
+        log != "mc" || dev_mapping != start_mapping || !corr_equal(dev_corr, start_corr))
+    {
+      remap_errors += 1;
+    }
+  }
+
+  typedef std::chrono::steady_clock Clock;
+  const int rounds = 200000;
+  Clock::time_point start = Clock::now();
+  long sum = 0;
+  for(int round = 0; round < rounds; ++round)
+  {
+    raw[round % raw.size()] = round & 0xffff;
+    engine.correct_all(raw.data(), out.data());
+    sum += out[round % out.size()];
+  }
+  double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / (double(rounds) * corrs.size());
+
+  std::cout << corrs.size() << " axes x 65536 values: " << mismatches << " mismatches\n"
+            << "permute_calibration: " << permute_errors << " errors in 1000 remap chains\n"
+            << "write_remap: " << remap_errors << " errors\n"
+            << "correct_all: " << ns << " ns per axis (" << sum << ")" << std::endl;
+
+  return mismatches == 0 && permute_errors == 0 && remap_errors == 0 ? 0 : 1;
+}
+
+#endif
+
+/* EOF */
@@ -0,0 +1,95 @@
+/*
+**  jstest-gtk - A graphical joystick tester
+**  Copyright (C) 2025 Raphael Rosch <jstest-bugs@insaner.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HEADER_JSTEST_GTK_CALIBRATION_ENGINE_HPP
+#define HEADER_JSTEST_GTK_CALIBRATION_ENGINE_HPP
+
+#include <functional>
+#include <linux/input.h>
+#include <linux/joystick.h>
+#include <stdint.h>
+#include <vector>
+
+/** Applies a set of js_corr to raw axis values the same way joydev
+    does, so the effect of a calibration can be shown before it is
+    written with JSIOCSCORR. The coefficients are kept as one array
+    per field, correct_all() is a straight loop over them that gcc
+    vectorizes at -O3, as in a Release build. At -O2 its cost model
+    leaves loops of unknown length alone. */
+class CalibrationEngine
+{
+private:
+  std::vector<int32_t> m_type;
+  std::vector<int32_t> m_center_min; // coef[0]
+  std::vector<int32_t> m_center_max; // coef[1]
+  std::vector<int32_t> m_slope_min;  // coef[2]
+  std::vector<int32_t> m_slope_max;  // coef[3]
+
+public:
+  CalibrationEngine();
+  explicit CalibrationEngine(const std::vector<struct js_corr>& corr);
+
+  void set(const std::vector<struct js_corr>& corr);
+  size_t size() const { return m_type.size(); }
+
+  /** Corrects a single value of \a axis */
+  int correct(size_t axis, int value) const;
+
+  /** Corrects one value per axis, \a raw and \a out have size()
+      elements and must not overlap */
+  void correct_all(const int* __restrict raw, int* __restrict out) const;
+};
+
+/** True when both sets would correct every value the same, compares
+    type, prec and all coefficients */
+bool corr_equal(const std::vector<struct js_corr>& lhs, const std::vector<struct js_corr>& rhs);
+
+/** joydev_correct() from drivers/input/joydev.c, the reference the
+    engine is tested against */
+int joydev_correct(int value, const struct js_corr& corr);
+
+/** joydev keeps the calibration per axis index, not per ABS_* code, so
+    it has to move along when the axis map changes. Reorders \a corr,
+    which belongs to \a mapping_old (axis index -> ABS_* code), for
+    \a mapping_new into \a out. Returns false and leaves \a out alone
+    when the sizes differ, a code is out of range or duplicated, or
+    \a mapping_new isn't a permutation of \a mapping_old. \a out may
+    be \a corr. */
+bool permute_calibration(const std::vector<struct js_corr>& corr,
+                         const std::vector<int>& mapping_old,
+                         const std::vector<int>& mapping_new,
+                         std::vector<struct js_corr>& out);
+
+enum RemapResult { REMAP_UNCHANGED, REMAP_INVALID, REMAP_WRITTEN };
+
+/** Moves the axes from \a mapping_old to \a mapping_new and their
+    calibration \a corr along: \a write_mapping gets the new map, then
+    \a write_corr the permuted calibration. When \a write_corr throws,
+    the old map is written back so the calibration doesn't end up on
+    the wrong axes, and the exception is passed on. Nothing is written
+    when the map is unchanged or invalid, see permute_calibration().
+    \a mapping_old is a copy, \a write_mapping may well replace it. */
+RemapResult write_remap(const std::vector<struct js_corr>& corr,
+                        std::vector<int> mapping_old,
+                        const std::vector<int>& mapping_new,
+                        const std::function<void (const std::vector<int>&)>& write_mapping,
+                        const std::function<void (const std::vector<struct js_corr>&)>& write_corr);
+
+#endif
+
+/* EOF */
@@ -0,0 +1,619 @@
+/*
+**  jstest-gtk - A graphical joystick tester
+**  Copyright (C) 2025 Raphael Rosch <jstest-bugs@insaner.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <errno.h>
+#include <fcntl.h>
+#include <functional>
+#include <iostream>
+#include <limits.h>
+#include <map>
+#include <set>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "config_cache.hpp"
+#include "parallel_for.hpp"
+#include "sdl_mapping.hpp"
+#include "verbose.hpp"
+
+namespace {
+
+// The cache is a private, per-machine file, so integers are stored in
+// native byte order. Bump the version whenever the layout below
+// changes.
+const char cache_magic[8] = { 'J', 'S', 'T', 'G', 'C', 'F', 'G', '\0' };
+const uint32_t cache_version = 2;
+
+typedef ConfigFileStamp FileStamp;
+
+struct CacheEntry
+{
+  std::string name;
+  FileStamp stamp;
+  std::vector<std::string> usb_ids;
+};
+
+bool get_file_stamp(const std::string& filename, FileStamp& stamp)
+{
+  struct stat st;
+  if (stat(filename.c_str(), &st) != 0)
+  {
+    return false;
+  }
+
+  stamp.mtime_sec  = st.st_mtim.tv_sec;
+  stamp.mtime_nsec = st.st_mtim.tv_nsec;
+  stamp.size       = S_ISDIR(st.st_mode) ? 0 : st.st_size;
+  return true;
+}
+
+class CacheWriter
+{
+private:
+  std::string m_data;
+
+public:
+  CacheWriter() : m_data() {}
+
+  void put_raw(const void* data, size_t len) { m_data.append(static_cast<const char*>(data), len); }
+  void put_u32(uint32_t value) { put_raw(&value, sizeof(value)); }
+  void put_i64(int64_t value) { put_raw(&value, sizeof(value)); }
+
+  void put_string(const std::string& str)
+  {
+    put_u32(static_cast<uint32_t>(str.size()));
+    put_raw(str.data(), str.size());
+  }
+
+  void put_strings(const std::vector<std::string>& strs)
+  {
+    put_u32(static_cast<uint32_t>(strs.size()));
+    for(const auto& str : strs)
+    {
+      put_string(str);
+    }
+  }
+
+  void put_stamp(const FileStamp& stamp)
+  {
+    put_i64(stamp.mtime_sec);
+    put_i64(stamp.mtime_nsec);
+    put_i64(stamp.size);
+  }
+
+  const std::string& get_data() const { return m_data; }
+};
+
+/** Bounds checked reader over the mapped cache file, once anything
+    doesn't fit all further reads fail */
+class CacheReader
+{
+private:
+  const char* m_ptr;
+  const char* m_end;
+  bool m_ok;
+
+public:
+  CacheReader(const char* data, size_t len) : m_ptr(data), m_end(data + len), m_ok(true) {}
+
+  bool ok() const { return m_ok; }
+  bool at_end() const { return m_ptr == m_end; }
+
+  bool get_raw(void* out, size_t len)
+  {
+    if (!m_ok || static_cast<size_t>(m_end - m_ptr) < len)
+    {
+      m_ok = false;
+      return false;
+    }
+    memcpy(out, m_ptr, len);
+    m_ptr += len;
+    return true;
+  }
+
+  bool get_u32(uint32_t& value) { return get_raw(&value, sizeof(value)); }
+  bool get_i64(int64_t& value) { return get_raw(&value, sizeof(value)); }
+
+  bool get_string(std::string& str)
+  {
+    uint32_t len;
+    if (!get_u32(len) || static_cast<size_t>(m_end - m_ptr) < len)
+    {
+      m_ok = false;
+      return false;
+    }
+    str.assign(m_ptr, len);
+    m_ptr += len;
+    return true;
+  }
+
+  bool get_strings(std::vector<std::string>& strs)
+  {
+    uint32_t count;
+    // every string needs at least its length field
+    if (!get_u32(count) || static_cast<size_t>(m_end - m_ptr) / sizeof(uint32_t) < count)
+    {
+      m_ok = false;
+      return false;
+    }
+    strs.resize(count);
+    for(auto& str : strs)
+    {
+      if (!get_string(str))
+      {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool get_stamp(FileStamp& stamp)
+  {
+    return get_i64(stamp.mtime_sec) && get_i64(stamp.mtime_nsec) && get_i64(stamp.size);
+  }
+};
+
+/** One cache file per config directory, named after a hash of its
+    absolute path; the path itself is stored in the header as well */
+std::string get_cache_filename(const std::string& directory, std::string& abs_directory)
+{
+  std::string cache_dir = get_config_cache_directory();
+  if (cache_dir.empty())
+  {
+    return std::string();
+  }
+
+  char buf[PATH_MAX];
+  abs_directory = realpath(directory.c_str(), buf) ? std::string(buf) : directory;
+
+  char name[64];
+  snprintf(name, sizeof(name), "/configs-%016llx.cache",
+           static_cast<unsigned long long>(std::hash<std::string>()(abs_directory)));
+  return cache_dir + name;
+}
+
+bool read_cache(const std::string& cache_filename, const std::string& abs_directory,
+                FileStamp& dir_stamp, std::vector<CacheEntry>& entries)
+{
+  int fd = open(cache_filename.c_str(), O_RDONLY);
+  if (fd < 0)
+  {
+    return false;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size == 0)
+  {
+    close(fd);
+    return false;
+  }
+
+  void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED)
+  {
+    return false;
+  }
+
+  CacheReader reader(static_cast<const char*>(data), st.st_size);
+
+  char magic[sizeof(cache_magic)];
+  uint32_t version;
+  std::string cached_directory;
+  uint32_t entry_count;
+  bool ok = (reader.get_raw(magic, sizeof(magic)) &&
+             memcmp(magic, cache_magic, sizeof(magic)) == 0 &&
+             reader.get_u32(version) && version == cache_version &&
+             reader.get_string(cached_directory) && cached_directory == abs_directory &&
+             reader.get_stamp(dir_stamp) &&
+             reader.get_u32(entry_count));
+
+  // a corrupt count must not turn into a huge allocation, every entry
+  // takes at least its name length, stamp and usb_id count
+  if (ok && entry_count > st.st_size / (2 * sizeof(uint32_t) + 3 * sizeof(int64_t)))
+  {
+    ok = false;
+  }
+
+  if (ok)
+  {
+    entries.resize(entry_count);
+    for(auto& entry : entries)
+    {
+      if (!reader.get_string(entry.name) ||
+          !reader.get_stamp(entry.stamp) ||
+          !reader.get_strings(entry.usb_ids))
+      {
+        ok = false;
+        break;
+      }
+    }
+    ok = ok && reader.at_end();
+  }
+
+  munmap(data, st.st_size);
+
+  if (!ok)
+  {
+    m_verbose and std::cout << cache_filename << ": ignoring invalid config cache" << std::endl;
+    entries.clear();
+  }
+  return ok;
+}
+
+void write_cache(const std::string& cache_filename, const std::string& abs_directory,
+                 const FileStamp& dir_stamp, const std::vector<CacheEntry>& entries)
+{
+  CacheWriter writer;
+  writer.put_raw(cache_magic, sizeof(cache_magic));
+  writer.put_u32(cache_version);
+  writer.put_string(abs_directory);
+  writer.put_stamp(dir_stamp);
+  writer.put_u32(static_cast<uint32_t>(entries.size()));
+  for(const auto& entry : entries)
+  {
+    writer.put_string(entry.name);
+    writer.put_stamp(entry.stamp);
+    writer.put_strings(entry.usb_ids);
+  }
+
+  std::string cache_dir = cache_filename.substr(0, cache_filename.rfind('/'));
+  if (!make_directories(cache_dir))
+  {
+    std::cout << cache_dir << ": " << strerror(errno) << std::endl;
+    return;
+  }
+
+  // write to a temporary file and rename it, so that a concurrently
+  // starting instance never maps a half written cache
+  std::string tmp_filename = cache_filename + ".tmp" + std::to_string(getpid());
+  FILE* out = fopen(tmp_filename.c_str(), "wb");
+  if (!out)
+  {
+    std::cout << tmp_filename << ": " << strerror(errno) << std::endl;
+    return;
+  }
+
+  const std::string& data = writer.get_data();
+  bool ok = fwrite(data.data(), 1, data.size(), out) == data.size();
+  ok = (fclose(out) == 0) && ok;
+
+  if (!ok || rename(tmp_filename.c_str(), cache_filename.c_str()) != 0)
+  {
+    std::cout << cache_filename << ": " << strerror(errno) << std::endl;
+    unlink(tmp_filename.c_str());
+  }
+}
+
+} // namespace
+
+bool make_directories(const std::string& path)
+{
+  for(std::string::size_type pos = path.find('/', 1); ; pos = path.find('/', pos + 1))
+  {
+    std::string sub = path.substr(0, pos);
+    if (mkdir(sub.c_str(), 0755) != 0 && errno != EEXIST)
+    {
+      return false;
+    }
+
+    if (pos == std::string::npos)
+    {
+      return true;
+    }
+  }
+}
+
+std::string get_config_cache_directory()
+{
+  const char* xdg_cache_home = getenv("XDG_CACHE_HOME");
+  if (xdg_cache_home && xdg_cache_home[0] == '/')
+  {
+    return std::string(xdg_cache_home) + "/jstest-gtk";
+  }
+
+  const char* home = getenv("HOME");
+  if (home && home[0] == '/')
+  {
+    return std::string(home) + "/.cache/jstest-gtk";
+  }
+
+  return std::string();
+}
+
+std::vector<JoystickConfigSource> load_config_sources_cached(const std::string& directory)
+{
+  std::vector<JoystickConfigSource> sources;
+
+  FileStamp dir_stamp;
+  if (!get_file_stamp(directory, dir_stamp))
+  {
+    return sources;
+  }
+
+  std::string abs_directory;
+  std::string cache_filename = get_cache_filename(directory, abs_directory);
+
+  FileStamp cached_dir_stamp;
+  std::vector<CacheEntry> cached;
+  bool have_cache = !cache_filename.empty() &&
+    read_cache(cache_filename, abs_directory, cached_dir_stamp, cached);
+
+  // files can only have been added, removed or renamed when the
+  // directory mtime changed, otherwise the readdir() can be skipped
+  bool dirty = !have_cache || !(cached_dir_stamp == dir_stamp);
+  std::vector<std::string> names;
+  if (dirty)
+  {
+    names = get_config_filenames(directory);
+  }
+  else
+  {
+    for(const auto& entry : cached)
+    {
+      names.push_back(entry.name);
+    }
+  }
+
+  std::map<std::string, CacheEntry*> cached_by_name;
+  for(auto& entry : cached)
+  {
+    cached_by_name[entry.name] = &entry;
+  }
+
+  // stat and scan the files in parallel, on a cold disk or a network
+  // home directory it's the per-file latency that adds up
+  enum { MISSING, CACHED, SCANNED };
+  std::vector<CacheEntry> found(names.size());
+  std::vector<int> state(names.size(), MISSING);
+  parallel_for(names.size(), [&](size_t i) {
+      CacheEntry& entry = found[i];
+      entry.name = names[i];
+      std::string filename = directory + "/" + entry.name;
+      if (!get_file_stamp(filename, entry.stamp))
+        return;
+
+      // names are unique, so no two threads touch the same cached entry
+      auto it = cached_by_name.find(entry.name);
+      if (it != cached_by_name.end() && it->second->stamp == entry.stamp)
+      {
+        entry.usb_ids = std::move(it->second->usb_ids);
+        state[i] = CACHED;
+      }
+      else
+      {
+        entry.usb_ids = scan_config(filename).usb_ids;
+        state[i] = SCANNED;
+      }
+    });
+
+  // merged in the order of names, which is sorted
+  std::vector<CacheEntry> entries;
+  entries.reserve(names.size());
+  int scanned = 0;
+  for(size_t i = 0; i < found.size(); ++i)
+  {
+    if (state[i] != CACHED)
+      dirty = true;
+
+    if (state[i] == SCANNED)
+      scanned += 1;
+
+    if (state[i] != MISSING)
+      entries.push_back(std::move(found[i]));
+  }
+
+  m_verbose and std::cout << "config index " << directory << ": " << entries.size() - scanned
+                          << " cached, " << scanned << " scanned" << std::endl;
+
+  if (dirty && !cache_filename.empty())
+  {
+    write_cache(cache_filename, abs_directory, dir_stamp, entries);
+  }
+
+  sources.resize(entries.size());
+  for(size_t i = 0; i < entries.size(); ++i)
+  {
+    sources[i].filename = directory + "/" + entries[i].name;
+    sources[i].usb_ids  = std::move(entries[i].usb_ids);
+    sources[i].stamp    = entries[i].stamp;
+  }
+  return sources;
+}
+
+std::shared_ptr<JoystickConfigRegistry> load_config_registry(const std::vector<std::string>& search_path,
+                                                             const JoystickConfigRegistry* previous,
+                                                             const std::vector<std::string>& changed)
+{
+  std::shared_ptr<JoystickConfigRegistry> registry = std::make_shared<JoystickConfigRegistry>();
+
+  // the registry lets the first config added win, so go through the
+  // layers from the most important one down
+  std::set<std::string> seen_directories;
+  std::set<std::string> seen_names;
+  for(auto dir = search_path.rbegin(); dir != search_path.rend(); ++dir)
+  {
+    char buf[PATH_MAX];
+    if (!realpath(dir->c_str(), buf) || !seen_directories.insert(buf).second)
+    {
+      continue; // missing, or the same directory under another name
+    }
+
+    m_verbose and std::cout << "loading config files in: " << *dir << std::endl;
+    for(const auto& source : load_config_sources_cached(*dir))
+    {
+      std::string name = source.filename.substr(source.filename.rfind('/') + 1);
+      if (!seen_names.insert(name).second)
+      {
+        m_verbose and std::cout << "overridden config: " << source.filename << std::endl;
+        continue;
+      }
+      registry->add(source);
+    }
+  }
+
+  // SDL mappings only fill in for devices without a .config
+  seen_directories.clear();
+  for(auto dir = search_path.rbegin(); dir != search_path.rend(); ++dir)
+  {
+    char buf[PATH_MAX];
+    if (realpath(dir->c_str(), buf) && seen_directories.insert(buf).second)
+    {
+      load_sdl_mappings(*dir + "/gamecontrollerdb.txt", *registry);
+    }
+  }
+
+  if (previous)
+  {
+    size_t reused = registry->reuse_configs(*previous, changed);
+    m_verbose and std::cout << "configs kept from before the reload: " << reused << std::endl;
+  }
+
+  return registry;
+}
+
+#ifdef __TEST__
+
+// g++ -std=c++11 -O2 -c joystick_config_files.cpp sdl_mapping.cpp parallel_for.cpp `pkg-config --cflags gtkmm-3.0`
+// g++ -std=c++11 -O2 -D__TEST__ config_cache.cpp joystick_config_files.o sdl_mapping.o parallel_for.o -o config-cache-test -pthread `pkg-config --cflags gtkmm-3.0`
+
+#include <chrono>
+#include <fstream>
+
+bool m_verbose = false;
+
+int main(int argc, char** argv)
+{
+  typedef std::chrono::steady_clock Clock;
+
+  const int config_count = argc > 1 ? atoi(argv[1]) : 2000;
+
+  char dir_template[] = "/tmp/jstest-gtk-config-cache-XXXXXX";
+  std::string tmpdir = mkdtemp(dir_template);
+  std::string datadir = tmpdir + "/data";
+  mkdir(datadir.c_str(), 0755);
+  setenv("XDG_CACHE_HOME", (tmpdir + "/cache").c_str(), 1);
+
+  for (int i = 0; i < config_count; ++i) {
+    char name[64];
+    snprintf(name, sizeof(name), "/controller-%05d.config", i);
+    std::ofstream out(datadir + name);
+    char usb_id[16];
+    snprintf(usb_id, sizeof(usb_id), "%04x:%04x", 0x1000 + i / 256, i % 256);
+    out << "# generated\nusb_id=" << usb_id << "\njs_type=xbox360\nicon_filename=xbox360.png\n";
+    for (int axis = 0; axis < 8; ++axis) out << "axis_" << axis << "=Axis " << axis << "\n";
+    for (int button = 0; button < 17; ++button) out << "button_" << button << "=Button " << button << "\n";
+  }
+
+  // a user directory overriding one file by name and another usb_id
+  // from a differently named file
+  std::string userdir = tmpdir + "/user";
+  mkdir(userdir.c_str(), 0755);
+  {
+    std::ofstream out(userdir + "/controller-00001.config");
+    out << "usb_id=1000:0001\njs_type=ps3-sixaxis\n";
+  }
+  {
+    std::ofstream out(userdir + "/my-pad.config");
+    out << "usb_id=1000:0002\njs_type=ps4-dualshock4\n";
+  }
+  {
+    std::ofstream out(userdir + "/gamecontrollerdb.txt");
+    out << "# SDL mappings\n"
+        << "03000000001000000000000010010000,Shadowed,a:b0,platform:Linux,\n"
+        << "03000000ad0b0000ef0b000010010000,SDL Pad,a:b0,b:b1,leftx:a0,lefty:a1,platform:Linux,\n"
+        << "03000000ad0b0000ef0b000000000000,SDL Pad,a:b0,platform:Windows,\n";
+  }
+  std::vector<std::string> search_path = { datadir, userdir };
+
+  Clock::time_point start = Clock::now();
+  std::vector<JoystickConfig> parsed = load_all_configs(datadir);
+  double parse_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+  start = Clock::now();
+  load_config_registry(search_path);
+  double cold_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+  start = Clock::now();
+  std::shared_ptr<JoystickConfigRegistry> registry = load_config_registry(search_path);
+  double warm_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+  start = Clock::now();
+  std::shared_ptr<const JoystickConfig> first = registry->find("1000:0000");
+  double first_us = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+
+  std::vector<JoystickConfigSource> sources = load_config_sources_cached(datadir);
+  bool same = sources.size() == parsed.size();
+  for (size_t i = 0; same && i < sources.size(); ++i) {
+    same = sources[i].usb_ids == parsed[i].usb_ids;
+  }
+  same = same && first && *first == parsed[0];
+
+  bool layered_ok = (registry->size() == parsed.size() + 3 &&
+                     registry->find("1000:0001")->js_type == "ps3-sixaxis" &&
+                     registry->find("1000:0002")->js_type == "ps4-dualshock4" &&
+                     registry->find("1000:0003")->js_type == "xbox360" &&
+                     get_joystick_configs()->size() == 0 &&
+                     registry->find_device(0x10000000, 0x0003100000000110ULL)->js_type == "xbox360" &&
+                     registry->find("0bad:0bef")->stick_axes.size() == 2);
+
+  // append to one file, only that one should get read again
+  {
+    std::ofstream out(datadir + "/controller-00000.config", std::ios::app);
+    out << "usb_id=dead:beef\n";
+  }
+  m_verbose = true;
+  std::shared_ptr<JoystickConfigRegistry> updated = load_config_registry(search_path, registry.get());
+  m_verbose = false;
+  bool updated_ok = updated->find("dead:beef") && updated->find("dead:beef")->usb_ids.size() == 2;
+  // configs parsed before the reload are taken over, not parsed again,
+  // so devices holding them still share the instance with the registry
+  bool reused_ok = (updated->find("1000:0003") == registry->find("1000:0003") &&
+                    updated->find("0bad:0bef") == registry->find("0bad:0bef") &&
+                    updated->find("1000:0000") != registry->find("1000:0000"));
+
+  // files the watcher reported are parsed again even with the same stamp
+  std::shared_ptr<const JoystickConfig> unreported = updated->find("1000:0004");
+  std::shared_ptr<JoystickConfigRegistry> reported =
+    load_config_registry(search_path, updated.get(), { datadir + "/controller-00003.config" });
+  reused_ok = (reused_ok &&
+               reported->find("1000:0003") != updated->find("1000:0003") &&
+               *reported->find("1000:0003") == *updated->find("1000:0003") &&
+               reported->find("1000:0004") == unreported);
+
+  std::cout << "configs:             " << registry->size() << "\n"
+            << "full parse:          " << parse_ms << " ms\n"
+            << "index (cold):        " << cold_ms << " ms\n"
+            << "index (cached):      " << warm_ms << " ms\n"
+            << "first lookup:        " << first_us << " us\n"
+            << "index matches parse: " << (same ? "yes" : "NO") << "\n"
+            << "user layer wins:     " << (layered_ok ? "yes" : "NO") << "\n"
+            << "picks up changes:    " << (updated_ok ? "yes" : "NO") << "\n"
+            << "keeps parsed ones:   " << (reused_ok ? "yes" : "NO") << std::endl;
+
+  std::string cmd = "rm -rf '" + tmpdir + "'";
+  return system(cmd.c_str()) == 0 && same && layered_ok && updated_ok && reused_ok ? 0 : 1;
+}
+#endif
+
+/* EOF */
@@ -0,0 +1,56 @@
+/*
+**  jstest-gtk - A graphical joystick tester
+**  Copyright (C) 2025 Raphael Rosch <jstest-bugs@insaner.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HEADER_JSTEST_GTK_CONFIG_CACHE_HPP
+#define HEADER_JSTEST_GTK_CONFIG_CACHE_HPP
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "joystick_config_files.hpp"
+
+/** Directory the binary config caches are stored in,
+    $XDG_CACHE_HOME/jstest-gtk/ or ~/.cache/jstest-gtk/ */
+std::string get_config_cache_directory();
+
+/** Creates \a path and its parents like mkdir -p, sets errno and
+    returns false on failure */
+bool make_directories(const std::string& path);
+
+/** scan_config() for every .config in \a directory, in sorted order.
+    Files whose mtime and size are unchanged are taken from a binary
+    cache of the previous run instead of being read again. The cache is
+    validated against the directory and file mtimes, memory mapped on
+    load and rewritten when anything changed. */
+std::vector<JoystickConfigSource> load_config_sources_cached(const std::string& directory);
+
+/** Indexes the config files of all directories in \a search_path,
+    see get_config_search_path(), followed by the gamecontrollerdb.txt
+    SDL mappings found there. Only the usb_ids and GUIDs are read up
+    front, each config is parsed when it is first looked up. On a
+    reload pass the registry in use as \a previous, the configs it
+    already parsed are kept for files that didn't change, the files
+    in \a changed are parsed again right away. */
+std::shared_ptr<JoystickConfigRegistry> load_config_registry(const std::vector<std::string>& search_path,
+                                                             const JoystickConfigRegistry* previous = nullptr,
+                                                             const std::vector<std::string>& changed = std::vector<std::string>());
+
+#endif
+
+/* EOF */
@@ -0,0 +1,155 @@
+/*
+**  jstest-gtk - A graphical joystick tester
+**  Copyright (C) 2025 Raphael Rosch <jstest-bugs@insaner.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <errno.h>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <glibmm/main.h>
+
+#include "config_watcher.hpp"
+#include "main.hpp"
+
+namespace {
+
+const uint32_t watch_mask = (IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM |
+                             IN_DELETE | IN_DELETE_SELF | IN_MOVE_SELF);
+
+bool is_config_filename(const std::string& name)
+{
+  return ((name.size() >= 7 && name.compare(name.size() - 7, 7, ".config") == 0) ||
+          name == "gamecontrollerdb.txt");
+}
+
+} // namespace
+
+ConfigWatcher::ConfigWatcher(int debounce_ms) :
+  m_fd(-1),
+  m_debounce_ms(debounce_ms),
+  m_watches(),
+  m_changed(),
+  m_io_connection(),
+  m_timeout_connection()
+{
+  m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (m_fd < 0)
+  {
+    std::ostringstream str;
+    str << "inotify_init1(): " << strerror(errno);
+    throw std::runtime_error(str.str());
+  }
+
+  auto channel = Glib::IOChannel::create_from_fd(m_fd);
+  channel->set_encoding();  // Binary
+  channel->set_buffered(false);
+
+  m_io_connection = Glib::signal_io().connect(sigc::mem_fun(this, &ConfigWatcher::on_io),
+                                              channel, Glib::IO_IN);
+}
+
+ConfigWatcher::~ConfigWatcher()
+{
+  m_timeout_connection.disconnect();
+  m_io_connection.disconnect();
+  close(m_fd);
+}
+
+void
+ConfigWatcher::add_directory(const std::string& directory)
+{
+  int wd = inotify_add_watch(m_fd, directory.c_str(), watch_mask);
+  if (wd < 0)
+  {
+    std::ostringstream str;
+    str << directory << ": " << strerror(errno);
+    throw std::runtime_error(str.str());
+  }
+
+  m_verbose and std::cout << "watching config directory: " << directory << std::endl;
+  m_watches[wd] = directory;
+}
+
+bool
+ConfigWatcher::on_io(Glib::IOCondition cond)
+{
+  alignas(struct inotify_event) char buf[4096];
+
+  while (true)
+  {
+    ssize_t len = read(m_fd, buf, sizeof(buf));
+    if (len <= 0)
+    {
+      break; // EAGAIN, all events consumed
+    }
+
+    for(char* ptr = buf; ptr < buf + len; )
+    {
+      const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(ptr);
+      ptr += sizeof(struct inotify_event) + event->len;
+
+      auto it = m_watches.find(event->wd);
+      if (it == m_watches.end())
+      {
+        continue;
+      }
+
+      if (event->mask & IN_IGNORED)
+      {
+        // directory is gone, inotify already dropped the watch
+        m_verbose and std::cout << it->second << ": no longer watched" << std::endl;
+        m_watches.erase(it);
+        continue;
+      }
+
+      std::string name = event->len ? std::string(event->name) : std::string();
+      if (!is_config_filename(name))
+      {
+        continue; // editor swap and backup files
+      }
+
+      m_changed.insert(it->second + "/" + name);
+    }
+  }
+
+  if (!m_changed.empty())
+  {
+    // restart the countdown on every event, so a burst ends in one reload
+    m_timeout_connection.disconnect();
+    m_timeout_connection = Glib::signal_timeout().connect(sigc::mem_fun(this, &ConfigWatcher::on_timeout),
+                                                          m_debounce_ms);
+  }
+
+  return true;
+}
+
+bool
+ConfigWatcher::on_timeout()
+{
+  std::vector<std::string> changed(m_changed.begin(), m_changed.end());
+  m_changed.clear();
+
+  m_verbose and std::cout << "config files changed: " << changed.size() << std::endl;
+  signal_changed(changed);
+
+  return false;
+}
+
+/* EOF */
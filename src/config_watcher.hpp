@@ -0,0 +1,67 @@
+/*
+**  jstest-gtk - A graphical joystick tester
+**  Copyright (C) 2025 Raphael Rosch <jstest-bugs@insaner.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HEADER_JSTEST_GTK_CONFIG_WATCHER_HPP
+#define HEADER_JSTEST_GTK_CONFIG_WATCHER_HPP
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include <glibmm/iochannel.h>
+#include <sigc++/signal.h>
+#include <sigc++/connection.h>
+
+/** Watches config directories with inotify. Editors tend to produce
+    a burst of events for a single save (write, rename, chmod, ...),
+    so changes are collected until the directories have been quiet
+    for the debounce time and then reported with a single signal. */
+class ConfigWatcher
+{
+private:
+  int m_fd;
+  int m_debounce_ms;
+  std::map<int, std::string> m_watches; // watch descriptor -> directory
+  std::set<std::string> m_changed;
+
+  sigc::connection m_io_connection;
+  sigc::connection m_timeout_connection;
+
+public:
+  ConfigWatcher(int debounce_ms = 250);
+  ~ConfigWatcher();
+
+  /** Start watching \a directory for changed .config files and
+      gamecontrollerdb.txt, throws when the directory can't be watched */
+  void add_directory(const std::string& directory);
+
+  /** Emitted with the config files that were written, created,
+      moved or deleted during the last burst of changes */
+  sigc::signal<void, const std::vector<std::string>&> signal_changed;
+
+private:
+  bool on_io(Glib::IOCondition cond);
+  bool on_timeout();
+
+  ConfigWatcher(const ConfigWatcher&);
+  ConfigWatcher& operator=(const ConfigWatcher&);
+};
+
+#endif
+
+/* EOF */
@@ -0,0 +1,174 @@
+/*
+**  jstest-gtk - A graphical joystick tester
+**  Copyright (C) 2025 Raphael Rosch <jstest-bugs@insaner.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <iostream>
+
+#include "device_metadata_cache.hpp"
+#include "main.hpp"
+
+DeviceMetadataCache* DeviceMetadataCache::instance_ = 0;
+
+DeviceMetadata::DeviceMetadata() :
+  syspath(),
+  filename(),
+  js_id(),
+  orig_name(),
+  name(),
+  vendor_id(),
+  product_id(),
+  usb_id(),
+  stable_id(),
+  sdl_guid(),
+  axis_count(0),
+  button_count(0),
+  js_cfg(get_empty_config())
+{
+}
+
+DeviceMetadataCache::DeviceMetadataCache() :
+  m_mutex(),
+  m_enabled(false),
+  m_seqnum(0),
+  m_entries(),
+  m_by_filename(),
+  m_last_change()
+{
+}
+
+void
+DeviceMetadataCache::enable()
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_enabled = true;
+}
+
+unsigned long long
+DeviceMetadataCache::get_seqnum()
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_seqnum;
+}
+
+bool
+DeviceMetadataCache::lookup(const std::string& filename, DeviceMetadata& metadata)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  if (!m_enabled)
+    return false;
+
+  auto it = m_by_filename.find(filename);
+  if (it == m_by_filename.end())
+    return false;
+
+  auto entry = m_entries.find(it->second);
+  if (entry == m_entries.end())
+    return false;
+
+  m_verbose and std::cout << filename << ": using cached metadata" << std::endl;
+  metadata = entry->second;
+  return true;
+}
+
+void
+DeviceMetadataCache::store(const DeviceMetadata& metadata, unsigned long long seqnum)
+{
+  if (metadata.syspath.empty())
+    return; // udev didn't know the device, nothing would invalidate it
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  if (!m_enabled)
+    return;
+
+  auto last_change = m_last_change.find(metadata.syspath);
+  if (last_change != m_last_change.end() && last_change->second > seqnum)
+    return; // changed while it was being read
+
+  m_entries[metadata.syspath] = metadata;
+  m_by_filename[metadata.filename] = metadata.syspath;
+}
+
+void
+DeviceMetadataCache::on_uevent(const std::string& action, const std::string& syspath, unsigned long long seqnum)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  m_seqnum = std::max(m_seqnum, seqnum);
+  m_last_change[syspath] = seqnum;
+
+  if (m_entries.count(syspath))
+  {
+    m_verbose and std::cout << "metadata cache: " << action << " " << syspath
+                            << " (SEQNUM " << seqnum << "), dropping entry" << std::endl;
+    erase(syspath);
+  }
+}
+
+void
+DeviceMetadataCache::update_configs()
+{
+  struct Update
+  {
+    std::string syspath;
+    std::string usb_id;
+    std::string sdl_guid;
+    std::shared_ptr<const JoystickConfig> js_cfg;
+  };
+
+  std::vector<Update> updates;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for(const auto& it : m_entries)
+    {
+      if (!it.second.usb_id.empty())
+        updates.push_back(Update{ it.first, it.second.usb_id, it.second.sdl_guid, nullptr });
+    }
+  }
+
+  // a lookup may have to parse the config, don't block the probe
+  // threads on that
+  for(auto& update : updates)
+  {
+    update.js_cfg = get_config_for_device(update.usb_id, update.sdl_guid);
+  }
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  for(const auto& update : updates)
+  {
+    auto it = m_entries.find(update.syspath);
+    if (it != m_entries.end() && it->second.usb_id == update.usb_id)
+      it->second.js_cfg = update.js_cfg;
+  }
+}
+
+void
+DeviceMetadataCache::erase(const std::string& syspath)
+{
+  auto it = m_entries.find(syspath);
+  if (it != m_entries.end())
+  {
+    auto by_filename = m_by_filename.find(it->second.filename);
+    if (by_filename != m_by_filename.end() && by_filename->second == syspath)
+      m_by_filename.erase(by_filename);
+    m_entries.erase(it);
+  }
+}
+
+/* EOF */
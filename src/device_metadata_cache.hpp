@@ -0,0 +1,111 @@
+/*
+**  jstest-gtk - A graphical joystick tester
+**  Copyright (C) 2025 Raphael Rosch <jstest-bugs@insaner.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HEADER_JSTEST_GTK_DEVICE_METADATA_CACHE_HPP
+#define HEADER_JSTEST_GTK_DEVICE_METADATA_CACHE_HPP
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "joystick.hpp"
+
+/** Everything about a joystick that takes ioctl or udev work to find
+    out and doesn't change while the device stays plugged in */
+struct DeviceMetadata
+{
+  std::string syspath;
+  std::string filename;
+  std::string js_id;
+  std::string orig_name;
+  std::string name; // UTF-8
+  std::string vendor_id;
+  std::string product_id;
+  std::string usb_id;
+  std::string stable_id;
+  std::string sdl_guid;
+  int axis_count;
+  int button_count;
+  std::shared_ptr<const JoystickConfig> js_cfg; // shared, never nullptr
+
+  DeviceMetadata();
+};
+
+/** Process wide cache of DeviceMetadata keyed by sysfs path. An entry
+    stays valid until udev reports a change for its sysfs path with a
+    SEQNUM newer than the one current when the entry was read, so it
+    is only trusted while a UdevMonitor feeds on_uevent(). Safe to use
+    from the probe worker threads. */
+class DeviceMetadataCache
+{
+private:
+  static DeviceMetadataCache* instance_;
+
+public:
+  static DeviceMetadataCache& instance() {
+    if (instance_)
+      return *instance_;
+    else
+      return *(instance_ = new DeviceMetadataCache());
+  }
+
+private:
+  std::mutex m_mutex;
+  bool m_enabled;
+  unsigned long long m_seqnum; // newest SEQNUM seen so far
+
+  std::unordered_map<std::string, DeviceMetadata> m_entries;        // syspath -> metadata
+  std::unordered_map<std::string, std::string> m_by_filename;       // devnode -> syspath
+  std::unordered_map<std::string, unsigned long long> m_last_change; // syspath -> SEQNUM
+
+public:
+  /** Called once udev events are being monitored, before that every
+      lookup misses */
+  void enable();
+
+  /** The SEQNUM to pass to store(), to be taken before reading the
+      device */
+  unsigned long long get_seqnum();
+
+  /** Copies the entry for \a filename into \a metadata, returns false
+      when there is none */
+  bool lookup(const std::string& filename, DeviceMetadata& metadata);
+
+  /** Stores \a metadata unless udev reported a change for its sysfs
+      path after \a seqnum, in which case it may already be stale */
+  void store(const DeviceMetadata& metadata, unsigned long long seqnum);
+
+  void on_uevent(const std::string& action, const std::string& syspath, unsigned long long seqnum);
+
+  /** Looks up js_cfg again for every entry, call after the config
+      registry got replaced */
+  void update_configs();
+
+private:
+  DeviceMetadataCache();
+
+  void erase(const std::string& syspath);
+
+  DeviceMetadataCache(const DeviceMetadataCache&);
+  DeviceMetadataCache& operator=(const DeviceMetadataCache&);
+};
+
+#endif
+
+/* EOF */
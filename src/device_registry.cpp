@@ -0,0 +1,209 @@
+/*
+**  jstest-gtk - A graphical joystick tester
+**  Copyright (C) 2025 Raphael Rosch <jstest-bugs@insaner.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "device_registry.hpp"
+
+int compare_device_files(const std::string& lhs, const std::string& rhs)
+{
+  if (lhs.size() != rhs.size())
+    return lhs.size() < rhs.size() ? -1 : 1;
+  else
+    return lhs.compare(rhs);
+}
+
+#ifdef __TEST__
+
+// g++ -std=c++11 -O2 -c joystick_config_files.cpp sdl_mapping.cpp parallel_for.cpp `pkg-config --cflags gtkmm-3.0`
+// g++ -std=c++11 -O2 -D__TEST__ device_registry.cpp joystick_config_files.o sdl_mapping.o parallel_for.o -o device-registry-test -pthread `pkg-config --cflags gtkmm-3.0`
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <set>
+#include <sstream>
+
+#include "joystick_config_files.hpp"
+
+bool m_verbose = false;
+
+namespace {
+
+// Stands in for the sorted Gtk::ListStore of JoystickListWidget, a
+// row is an iterator that, like a Gtk::TreeRowReference, stays valid
+// while other rows come and go
+struct FakeRow
+{
+  std::string path;
+  std::string name;
+  std::string icon;
+};
+
+struct FakeRowLess
+{
+  bool operator()(const FakeRow& lhs, const FakeRow& rhs) const
+  {
+    return compare_device_files(lhs.path, rhs.path) < 0;
+  }
+};
+
+typedef std::multiset<FakeRow, FakeRowLess> FakeList;
+
+// same steps as JoystickListWidget::on_joystick_probed()
+void add_row(DeviceRegistry<FakeList::iterator>& registry, FakeList& list,
+             const JoystickDescription& joystick)
+{
+  registry.update(joystick,
+                  [&list](FakeList::iterator row) { list.erase(row); },
+                  [&list](const JoystickDescription& description,
+                          const DeviceRegistry<FakeList::iterator>::Device* sibling) {
+                    FakeRow row;
+                    if (sibling)
+                    {
+                      row.icon = sibling->row->icon;
+                    }
+                    else
+                    {
+                      std::shared_ptr<const JoystickConfig> js_cfg = get_config_for_usb_id(description.usb_id);
+                      row.icon = js_cfg->icon_filename.empty() ? "generic.png" : js_cfg->icon_filename;
+                    }
+                    row.path = description.filename;
+
+                    std::ostringstream out;
+                    out << description.name << "\n"
+                        << "Device: " << description.filename << "\n"
+                        << "usb_id: " << description.usb_id << "\n"
+                        << "Axes: " << description.axis_count << "\n"
+                        << "Buttons: " << description.button_count;
+                    row.name = out.str();
+
+                    return list.insert(row);
+                  });
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  const int count = (argc > 1) ? std::stoi(argv[1]) : 500;
+  const int models = 50;
+  const int rounds = 200;
+
+  std::vector<JoystickConfig> configs(models);
+  for(int i = 0; i < models; ++i)
+  {
+    configs[i].usb_ids.push_back("1234:" + std::to_string(1000 + i));
+    configs[i].icon_filename = "model" + std::to_string(i) + ".png";
+  }
+  set_joystick_configs(std::make_shared<JoystickConfigRegistry>(configs));
+
+  std::vector<JoystickDescription> descriptions;
+  for(int i = 0; i < count; ++i)
+  {
+    // a few models, many devices each
+    std::string product_id = std::to_string(1000 + i % models);
+    descriptions.push_back(JoystickDescription("/dev/input/js" + std::to_string(i),
+                                               "Fake Joystick " + std::to_string(i),
+                                               "js" + std::to_string(i),
+                                               "1234", product_id,
+                                               "1234:" + product_id,
+                                               8, 16,
+                                               "/sys/devices/virtual/input/input" + std::to_string(i)
+                                               + "/js" + std::to_string(i)));
+  }
+
+  // probes complete in any order
+  std::mt19937 rng(0);
+  std::vector<JoystickDescription> probed = descriptions;
+  std::shuffle(probed.begin(), probed.end(), rng);
+
+  typedef std::chrono::steady_clock Clock;
+
+  int errors = 0;
+  DeviceRegistry<FakeList::iterator> registry;
+  FakeList list;
+
+  Clock::time_point start = Clock::now();
+  for(int r = 0; r < rounds; ++r)
+  {
+    // on_refresh_button()
+    list.clear();
+    registry.clear();
+    for(const auto& description : probed)
+    {
+      add_row(registry, list, description);
+    }
+  }
+  double populate_us = std::chrono::duration<double, std::micro>(Clock::now() - start).count() / rounds;
+
+  // a device that gets probed again replaces its row
+  add_row(registry, list, descriptions.front());
+  if (list.size() != descriptions.size() || registry.size() != descriptions.size())
+    errors += 1;
+
+  int expected = 0;
+  for(const auto& row : list)
+  {
+    if (row.path != descriptions[expected].filename ||
+        row.icon != "model" + std::to_string(expected % models) + ".png")
+      errors += 1;
+    expected += 1;
+  }
+
+  // hotplug: a device goes away and comes back
+  start = Clock::now();
+  for(int r = 0; r < rounds; ++r)
+  {
+    for(const auto& description : probed)
+    {
+      registry.remove(description.filename, [&list](FakeList::iterator row) { list.erase(row); });
+      add_row(registry, list, description);
+    }
+  }
+  double hotplug_ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count()
+    / (double(rounds) * count);
+
+  size_t found = 0;
+  start = Clock::now();
+  for(int r = 0; r < rounds; ++r)
+  {
+    for(const auto& description : probed)
+    {
+      found += registry.find_by_filename(description.filename) != nullptr;
+      found += registry.find_by_syspath(description.syspath) != nullptr;
+      found += registry.find_by_usb_id(description.usb_id) != nullptr;
+    }
+  }
+  double lookup_ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count()
+    / (double(rounds) * count * 3.0);
+
+  if (found != size_t(rounds) * count * 3 || list.size() != descriptions.size())
+    errors += 1;
+
+  std::cout << "devices:          " << registry.size() << "\n"
+            << "populate:         " << populate_us << " us per full list\n"
+            << "hotplug:          " << hotplug_ns << " ns per remove and add\n"
+            << "lookup:           " << lookup_ns << " ns per lookup\n"
+            << "errors:           " << errors << std::endl;
+
+  return errors == 0 ? 0 : 1;
+}
+#endif
+
+/* EOF */
@@ -0,0 +1,160 @@
+/*
+**  jstest-gtk - A graphical joystick tester
+**  Copyright (C) 2025 Raphael Rosch <jstest-bugs@insaner.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HEADER_JSTEST_GTK_DEVICE_REGISTRY_HPP
+#define HEADER_JSTEST_GTK_DEVICE_REGISTRY_HPP
+
+#include <string>
+#include <unordered_map>
+
+#include "joystick_description.hpp"
+
+/** Orders device files by length first, so that js2 comes before js10 */
+int compare_device_files(const std::string& lhs, const std::string& rhs);
+
+/** The set of currently known joysticks, each with the \a Row that
+    shows it, with constant time lookup by device file, sysfs path and
+    usb_id */
+template<class Row>
+class DeviceRegistry
+{
+public:
+  struct Device
+  {
+    JoystickDescription description;
+    Row row;
+  };
+
+private:
+  std::unordered_map<std::string, Device> m_devices;              // devnode -> device
+  std::unordered_map<std::string, std::string> m_by_syspath;      // syspath -> devnode
+  std::unordered_multimap<std::string, std::string> m_by_usb_id;  // usb_id -> devnode
+
+public:
+  DeviceRegistry() :
+    m_devices(),
+    m_by_syspath(),
+    m_by_usb_id()
+  {}
+
+  /** Adds \a description in place of any device with the same device
+      file. \a erase_row is called with the row of the replaced device,
+      \a create_row with the new description and another device of the
+      same usb_id, or nullptr, to copy what only depends on the model
+      from; it returns the new row. */
+  template<class EraseRow, class CreateRow>
+  Device& update(const JoystickDescription& description, EraseRow erase_row, CreateRow create_row)
+  {
+    remove(description.filename, erase_row);
+
+    Row row = create_row(description, find_by_usb_id(description.usb_id));
+
+    Device& device = m_devices[description.filename];
+    device.description = description;
+    device.row = row;
+
+    if (!description.syspath.empty())
+      m_by_syspath[description.syspath] = description.filename;
+
+    if (!description.usb_id.empty())
+      m_by_usb_id.insert(std::make_pair(description.usb_id, description.filename));
+
+    return device;
+  }
+
+  /** Removes the device with the device file \a filename, \a erase_row
+      is called with its row */
+  template<class EraseRow>
+  bool remove(const std::string& filename, EraseRow erase_row)
+  {
+    auto it = m_devices.find(filename);
+    if (it == m_devices.end())
+    {
+      return false;
+    }
+    else
+    {
+      const JoystickDescription& description = it->second.description;
+
+      auto syspath_it = m_by_syspath.find(description.syspath);
+      if (syspath_it != m_by_syspath.end() && syspath_it->second == filename)
+        m_by_syspath.erase(syspath_it);
+
+      auto range = m_by_usb_id.equal_range(description.usb_id);
+      for(auto usb_it = range.first; usb_it != range.second; ++usb_it)
+      {
+        if (usb_it->second == filename)
+        {
+          m_by_usb_id.erase(usb_it);
+          break;
+        }
+      }
+
+      erase_row(it->second.row);
+      m_devices.erase(it);
+      return true;
+    }
+  }
+
+  /** Forgets all devices, their rows are left to the caller */
+  void clear()
+  {
+    m_devices.clear();
+    m_by_syspath.clear();
+    m_by_usb_id.clear();
+  }
+
+  /** The returned pointers stay valid until the device is removed */
+  const Device* find_by_filename(const std::string& filename) const
+  {
+    auto it = m_devices.find(filename);
+    if (it == m_devices.end())
+      return nullptr;
+    else
+      return &it->second;
+  }
+
+  const Device* find_by_syspath(const std::string& syspath) const
+  {
+    auto it = m_by_syspath.find(syspath);
+    if (it == m_by_syspath.end())
+      return nullptr;
+    else
+      return find_by_filename(it->second);
+  }
+
+  /** One of the devices with \a usb_id, nullptr if there is none */
+  const Device* find_by_usb_id(const std::string& usb_id) const
+  {
+    auto it = m_by_usb_id.find(usb_id);
+    if (it == m_by_usb_id.end())
+      return nullptr;
+    else
+      return find_by_filename(it->second);
+  }
+
+  size_t size() const { return m_devices.size(); }
+
+private:
+  DeviceRegistry(const DeviceRegistry&);
+  DeviceRegistry& operator=(const DeviceRegistry&);
+};
+
+#endif
+
+/* EOF */
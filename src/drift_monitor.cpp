@@ -0,0 +1,197 @@
+/*
+**  jstest-gtk - A graphical joystick tester
+**  Copyright (C) 2025 Raphael Rosch <jstest-bugs@insaner.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "drift_monitor.hpp"
+
+namespace {
+
+// samples in an idle stretch before its spread is judged
+const uint32_t min_noise_samples = 64;
+// the center average weights each sample with 1/2^center_shift
+const int center_shift = 10;
+// idle samples before the center average settles into the reference
+const uint32_t settle_samples = 256;
+
+} // namespace
+
+DriftMonitor::DriftMonitor(int axis_count, int idle_band) :
+  m_axes(axis_count),
+  m_idle_band(idle_band)
+{
+  for(auto& axis : m_axes)
+  {
+    axis.noise_limit = 256;
+    axis.drift_limit = 1024;
+    reset_axis(axis);
+  }
+}
+
+void
+DriftMonitor::set_limits(int axis, int noise_limit, int drift_limit)
+{
+  m_axes[axis].noise_limit = noise_limit;
+  m_axes[axis].drift_limit = drift_limit;
+}
+
+void
+DriftMonitor::reset()
+{
+  for(auto& axis : m_axes)
+  {
+    reset_axis(axis);
+  }
+}
+
+void
+DriftMonitor::reset_axis(Axis& axis)
+{
+  axis.count = 0;
+  axis.mean = 0.0;
+  axis.m2 = 0.0;
+  axis.center = 0;
+  axis.center_count = 0;
+  axis.reference = 0;
+  axis.status = STATUS_OK;
+}
+
+double
+DriftMonitor::get_noise(int axis) const
+{
+  const Axis& state = m_axes[axis];
+  return state.count > 1 ? sqrt(state.m2 / (state.count - 1)) : 0.0;
+}
+
+bool
+DriftMonitor::update(int number, int value)
+{
+  if (number < 0 || number >= static_cast<int>(m_axes.size()))
+    return false;
+
+  Axis& axis = m_axes[number];
+
+  if (axis.center_count == 0)
+  {
+    axis.center = static_cast<int64_t>(value) << 16;
+  }
+  else if (abs(value - get_center(number)) > m_idle_band)
+  {
+    // being moved, the next idle stretch starts from scratch
+    axis.count = 0;
+    axis.mean = 0.0;
+    axis.m2 = 0.0;
+    return false;
+  }
+
+  // the spread is taken around the center average, so a slow drift
+  // doesn't count as noise
+  double residual = value - get_center(number);
+  axis.count += 1;
+  double delta = residual - axis.mean;
+  axis.mean += delta / axis.count;
+  axis.m2 += delta * (residual - axis.mean);
+
+  axis.center += ((static_cast<int64_t>(value) << 16) - axis.center) >> center_shift;
+  axis.center_count += 1;
+  if (axis.center_count == settle_samples)
+  {
+    axis.reference = get_center(number);
+  }
+
+  int status = STATUS_OK;
+  double limit = axis.noise_limit;
+  if (axis.count >= min_noise_samples && axis.m2 > limit * limit * (axis.count - 1))
+  {
+    status |= STATUS_NOISY;
+  }
+  if (axis.center_count >= settle_samples && abs(get_center(number) - axis.reference) > axis.drift_limit)
+  {
+    status |= STATUS_DRIFTING;
+  }
+
+  if (status != axis.status)
+  {
+    axis.status = status;
+    return true;
+  }
+  return false;
+}
+
+#ifdef __TEST__
+
+// g++ -std=c++11 -O2 -D__TEST__ drift_monitor.cpp -o drift-monitor-test
+
+#include <chrono>
+#include <iostream>
+#include <random>
+
+int main(int argc, char** argv)
+{
+  bool ok = true;
+  std::mt19937 rng(0);
+  std::normal_distribution<double> small_noise(0.0, 30.0);
+  std::normal_distribution<double> large_noise(0.0, 600.0);
+
+  DriftMonitor monitor(3);
+
+  // axis 0 rests quietly, axis 1 is noisy, axis 2 creeps away from
+  // its center, with the user moving axis 0 around in between
+  for(int i = 0; i < 20000; ++i)
+  {
+    if (i % 1000 < 100)
+      monitor.update(0, (i % 100) * 300);
+    else
+      monitor.update(0, static_cast<int>(small_noise(rng)));
+    monitor.update(1, static_cast<int>(large_noise(rng)));
+    monitor.update(2, static_cast<int>(small_noise(rng)) + i / 8);
+  }
+
+  std::cout << "axis 0: status " << monitor.get_status(0) << " noise " << monitor.get_noise(0)
+            << " center " << monitor.get_center(0) << std::endl;
+  std::cout << "axis 1: status " << monitor.get_status(1) << " noise " << monitor.get_noise(1)
+            << " center " << monitor.get_center(1) << std::endl;
+  std::cout << "axis 2: status " << monitor.get_status(2) << " noise " << monitor.get_noise(2)
+            << " center " << monitor.get_center(2) << " reference " << monitor.get_reference(2) << std::endl;
+  ok = ok && monitor.get_status(0) == DriftMonitor::STATUS_OK;
+  ok = ok && monitor.get_status(1) == DriftMonitor::STATUS_NOISY;
+  ok = ok && monitor.get_status(2) == DriftMonitor::STATUS_DRIFTING;
+
+  // cost per event
+  std::vector<int> values(1 << 16);
+  for(auto& value : values)
+    value = static_cast<int>(small_noise(rng));
+
+  const int rounds = 200;
+  auto start = std::chrono::steady_clock::now();
+  int changes = 0;
+  for(int round = 0; round < rounds; ++round)
+    for(size_t i = 0; i < values.size(); ++i)
+      changes += monitor.update(i & 1, values[i]);
+  auto end = std::chrono::steady_clock::now();
+  double ns = std::chrono::duration<double, std::nano>(end - start).count() / (rounds * values.size());
+  std::cout << "update: " << ns << " ns per event (" << changes << " changes)" << std::endl;
+
+  std::cout << (ok ? "ok" : "WRONG") << std::endl;
+  return ok ? 0 : 1;
+}
+
+#endif
+
+/* EOF */
@@ -0,0 +1,83 @@
+/*
+**  jstest-gtk - A graphical joystick tester
+**  Copyright (C) 2025 Raphael Rosch <jstest-bugs@insaner.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HEADER_JSTEST_GTK_DRIFT_MONITOR_HPP
+#define HEADER_JSTEST_GTK_DRIFT_MONITOR_HPP
+
+#include <stdint.h>
+#include <vector>
+
+/** Watches the axes while they are left alone. Each idle stretch keeps
+    a running mean and variance (Welford), and a slow moving average of
+    the center follows all idle samples. An axis is flagged as noisy
+    when the spread at rest exceeds its noise limit and as drifting
+    when the center moved further than its drift limit from where it
+    first settled. Memory is constant per axis. */
+class DriftMonitor
+{
+public:
+  enum Status { STATUS_OK = 0, STATUS_NOISY = 1, STATUS_DRIFTING = 2 };
+
+private:
+  struct Axis
+  {
+    // Welford over the distance to the center during the current idle
+    // stretch
+    uint32_t count;
+    double mean;
+    double m2;
+
+    // center average in 1/65536th, updated with a shift
+    int64_t center;
+    uint32_t center_count;
+    int reference;
+
+    int noise_limit;
+    int drift_limit;
+    int status;
+  };
+
+  std::vector<Axis> m_axes;
+  int m_idle_band;
+
+public:
+  /** Samples further than \a idle_band from the center count as the
+      user moving the axis */
+  DriftMonitor(int axis_count, int idle_band = 8192);
+
+  void set_limits(int axis, int noise_limit, int drift_limit);
+
+  /** Forget all measurements, e.g. after the calibration changed */
+  void reset();
+
+  /** Feed the axis_move stream, returns true when the status of
+      \a axis changed */
+  bool update(int axis, int value);
+
+  int get_status(int axis) const { return m_axes[axis].status; }
+  int get_center(int axis) const { return static_cast<int>(m_axes[axis].center >> 16); }
+  int get_reference(int axis) const { return m_axes[axis].reference; }
+  double get_noise(int axis) const;
+
+private:
+  void reset_axis(Axis& axis);
+};
+
+#endif
+
+/* EOF */
@@ -0,0 +1,90 @@
+/*
+**  jstest-gtk - A graphical joystick tester
+**  Copyright (C) 2025 Raphael Rosch <jstest-bugs@insaner.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <iostream>
+
+#include "icon_cache.hpp"
+#include "main.hpp"
+
+IconCache* IconCache::instance_ = 0;
+
+IconCache::IconCache() :
+  m_icons(),
+  m_hits(0),
+  m_misses(0)
+{
+}
+
+Glib::RefPtr<Gdk::Pixbuf>
+IconCache::get(const std::string& filename, int size)
+{
+  auto key = std::make_pair(filename, size);
+  auto it = m_icons.find(key);
+  if (it != m_icons.end())
+  {
+    m_hits += 1;
+    m_verbose and std::cout << "icon cache hit: " << filename << " @ " << size
+                            << " (hits: " << m_hits << ", misses: " << m_misses << ")" << std::endl;
+    return it->second;
+  }
+  else
+  {
+    m_misses += 1;
+    m_verbose and std::cout << "icon cache miss: " << filename << " @ " << size
+                            << " (hits: " << m_hits << ", misses: " << m_misses << ")" << std::endl;
+    Glib::RefPtr<Gdk::Pixbuf> pixbuf = load(filename, size);
+    m_icons[key] = pixbuf;
+    return pixbuf;
+  }
+}
+
+Glib::RefPtr<Gdk::Pixbuf>
+IconCache::load(const std::string& filename, int size)
+{
+  if (size >= 0)
+  {
+    // scale from the cached native size instead of decoding again
+    Glib::RefPtr<Gdk::Pixbuf> native = get(filename);
+    if (!native ||
+        (native->get_width() <= size && native->get_height() <= size))
+    {
+      return native;
+    }
+    else
+    {
+      int width  = std::max(1, native->get_width()  * size / std::max(native->get_width(), native->get_height()));
+      int height = std::max(1, native->get_height() * size / std::max(native->get_width(), native->get_height()));
+      return native->scale_simple(width, height, Gdk::INTERP_BILINEAR);
+    }
+  }
+  else
+  {
+    try
+    {
+      return Gdk::Pixbuf::create_from_file(filename);
+    }
+    catch(const Glib::Error& err)
+    {
+      std::cout << filename << ": " << err.what() << std::endl;
+      return Glib::RefPtr<Gdk::Pixbuf>();
+    }
+  }
+}
+
+/* EOF */
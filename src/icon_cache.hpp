@@ -0,0 +1,69 @@
+/*
+**  jstest-gtk - A graphical joystick tester
+**  Copyright (C) 2025 Raphael Rosch <jstest-bugs@insaner.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HEADER_JSTEST_GTK_ICON_CACHE_HPP
+#define HEADER_JSTEST_GTK_ICON_CACHE_HPP
+
+#include <map>
+#include <string>
+#include <utility>
+#include <gdkmm/pixbuf.h>
+
+/** Process wide cache of decoded icons, shared by the device list and
+    the test windows. Files are only opened on first use, failures are
+    remembered as well so a broken icon_filename is only tried once. */
+class IconCache
+{
+private:
+  static IconCache* instance_;
+
+public:
+  static IconCache& instance() {
+    if (instance_)
+      return *instance_;
+    else
+      return *(instance_ = new IconCache());
+  }
+
+private:
+  // (filename, size) -> pixbuf, an empty RefPtr marks a failed load
+  std::map<std::pair<std::string, int>, Glib::RefPtr<Gdk::Pixbuf> > m_icons;
+  unsigned int m_hits;
+  unsigned int m_misses;
+
+public:
+  /** Returns the icon stored in \a filename, scaled down to fit into
+      \a size x \a size pixels, or at its native size when \a size is
+      negative. Returns an empty RefPtr when the file can't be loaded. */
+  Glib::RefPtr<Gdk::Pixbuf> get(const std::string& filename, int size = -1);
+
+  unsigned int get_hits() const   { return m_hits; }
+  unsigned int get_misses() const { return m_misses; }
+
+private:
+  IconCache();
+
+  Glib::RefPtr<Gdk::Pixbuf> load(const std::string& filename, int size);
+
+  IconCache(const IconCache&);
+  IconCache& operator=(const IconCache&);
+};
+
+#endif
+
+/* EOF */
@@ -23,6 +23,7 @@
 #include <iostream>
 #include <stdexcept>
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 #include <errno.h>
 #include <sys/types.h>
@@ -31,12 +32,17 @@
 #include <string.h>
 #include <sstream>
 #include <unistd.h>
+#include <dirent.h>
 #include <linux/joystick.h>
 #include <glibmm.h>
 
+#include "calibration_engine.hpp"
+#include "device_metadata_cache.hpp"
 #include "evdev_helper.hpp"
 #include "joystick.hpp"
 #include "main.hpp"
+#include "sdl_mapping.hpp"
+#include "udev_monitor.hpp"
 
 std::string get_js_dev_id_from_filename(const std::string& filename)
 {
@@ -50,54 +56,99 @@ std::string get_js_dev_id_from_filename(const std::string& filename)
 
 Joystick::Joystick(const std::string& filename_, const std::string& js_id_)
   : filename(filename_),
-    js_id(js_id_)
+    js_id(js_id_),
+    corr_cache(),
+    calibration_cache(),
+    calibration_dirty(true),
+    axis_mapping_cache(),
+    axis_mapping_dirty(true),
+    connection(),
+    event_time(0),
+    event_is_initial(false),
+    js_cfg(get_empty_config())
 {
   try {
     fd = get_new_joystick_fd(); // throws error
     // ok
-    uint8_t num_axis   = 0;
-    uint8_t num_button = 0;
-    ioctl(fd, JSIOCGAXES,    &num_axis);
-    ioctl(fd, JSIOCGBUTTONS, &num_button);
-    axis_count   = num_axis;
-    button_count = num_button;
-
-    // Get Name
-    char name_c_str[1024];
-    if (ioctl(fd, JSIOCGNAME(sizeof(name_c_str)), name_c_str) < 0)
+    DeviceMetadataCache& cache = DeviceMetadataCache::instance();
+    unsigned long long seqnum = cache.get_seqnum();
+    DeviceMetadata metadata;
+    if (!cache.lookup(filename, metadata))
     {
-      std::ostringstream str;
-      str << filename << ": " << strerror(errno);
-      throw std::runtime_error(str.str());
-    }
-    else
-    {
-      orig_name = name_c_str;
-      try {
-        name = Glib::convert_with_fallback(name_c_str, "UTF-8", "ISO-8859-1");
-      } catch(Glib::ConvertError& err) {
-        std::cout << err.what() << std::endl;
-      }
+      read_metadata(fd, filename, js_id, metadata);
+      cache.store(metadata, seqnum);
     }
 
+    orig_name    = metadata.orig_name;
+    name         = metadata.name;
+    vendor_id    = metadata.vendor_id;
+    product_id   = metadata.product_id;
+    usb_id       = metadata.usb_id;
+    stable_id    = metadata.stable_id;
+    sdl_guid     = metadata.sdl_guid;
+    axis_count   = metadata.axis_count;
+    button_count = metadata.button_count;
+    js_cfg       = metadata.js_cfg;
+    // js_type = get_js_type_from_usb_id(usb_id);
+    js_type      = get_js_type_from_config(*js_cfg);
+
     axis_state.resize(axis_count);
     
-    auto tmp_usb_id_pair = get_usb_id_pair_from_udev();
-    if (!tmp_usb_id_pair.first.empty() and !tmp_usb_id_pair.second.empty()) {
-      vendor_id = tmp_usb_id_pair.first;
-      product_id = tmp_usb_id_pair.second;
-      usb_id = vendor_id + ":" + product_id;
-      js_cfg = get_config_for_usb_id(usb_id);
-      // js_type = get_js_type_from_usb_id(usb_id);
-      js_type = get_js_type_from_config(js_cfg);
-    }
     connect_js();
+
+    // not cached with the metadata, jscal or another window may have
+    // changed it since, and "Revert" has to go back to what the
+    // device has now
     orig_calibration_data = get_calibration();
   } catch(std::runtime_error& err) {
     std::cout << err.what() << std::endl;
   }
 }
 
+void
+Joystick::read_metadata(int fd, const std::string& filename, const std::string& js_id,
+                        DeviceMetadata& metadata)
+{
+  metadata.filename = filename;
+  metadata.js_id    = js_id;
+
+  uint8_t num_axis   = 0;
+  uint8_t num_button = 0;
+  ioctl(fd, JSIOCGAXES,    &num_axis);
+  ioctl(fd, JSIOCGBUTTONS, &num_button);
+  metadata.axis_count   = num_axis;
+  metadata.button_count = num_button;
+
+  // Get Name
+  char name_c_str[1024];
+  if (ioctl(fd, JSIOCGNAME(sizeof(name_c_str)), name_c_str) < 0)
+  {
+    std::ostringstream str;
+    str << filename << ": " << strerror(errno);
+    throw std::runtime_error(str.str());
+  }
+  else
+  {
+    metadata.orig_name = name_c_str;
+    try {
+      metadata.name = Glib::convert_with_fallback(name_c_str, "UTF-8", "ISO-8859-1");
+    } catch(Glib::ConvertError& err) {
+      std::cout << err.what() << std::endl;
+    }
+  }
+
+  UdevInfo udev_info = get_udev_info(filename, js_id);
+  metadata.syspath   = udev_info.syspath;
+  metadata.stable_id = udev_info.stable_id;
+  metadata.sdl_guid  = udev_info.sdl_guid;
+  if (!udev_info.vendor_id.empty() and !udev_info.product_id.empty()) {
+    metadata.vendor_id  = udev_info.vendor_id;
+    metadata.product_id = udev_info.product_id;
+    metadata.usb_id     = metadata.vendor_id + ":" + metadata.product_id;
+    metadata.js_cfg     = get_config_for_device(metadata.usb_id, metadata.sdl_guid);
+  }
+}
+
 Joystick::~Joystick()
 {
   connection.disconnect();
@@ -129,79 +180,148 @@ Joystick::connect_js()
 }
 
 bool
-Joystick::reconnected()   // TODO: jsX devnum needs to be same after reconnecting, or below won't work (eg, reconnecting in different order) 
+Joystick::reconnect(const std::string& filename_)
 {
-  m_verbose and std::cout << "attempting joystick reconnect... " << std::endl;
+  m_verbose and std::cout << "attempting joystick reconnect: " << filename_ << std::endl;
 
-  try {
-    int tmp_fd = get_new_joystick_fd();
+  int tmp_fd = open(filename_.c_str(), O_RDONLY);
+  if (tmp_fd < 0)
+  {
+    std::cout << filename_ << ": " << strerror(errno) << std::endl;
+    return false;
+  }
 
-    char name_c_str[1024];
-    if (ioctl(tmp_fd, JSIOCGNAME(sizeof(name_c_str)), name_c_str) < 0)
-    {
-      m_verbose and std::cout << "could not get name from fd "  << std::endl;
-      return false;
-    }
-    if (orig_name != name_c_str)
-    {
-      m_verbose and std::cout << "name mismatch"  << std::endl;
-      return false;
-    }
-    auto tmp_usb_id_pair = get_usb_id_pair_from_udev();
-    std::string tmp_usb_id = tmp_usb_id_pair.first + ":" + tmp_usb_id_pair.second;
-    if (tmp_usb_id != usb_id)
-    {
-      m_verbose and std::cout << "usb_id mismatch"  << std::endl;
-      return false;
-    }
-    // std::string tmp_js_type = get_js_type_from_usb_id(tmp_usb_id);
-    std::string tmp_js_type = get_js_type_from_config(js_cfg);
-    if (tmp_js_type != js_type)
-    {
-      m_verbose and std::cout << "js_type mismatch"  << std::endl;
-      return false;
-    }
-    fd = tmp_fd;
-    connect_js();
-  } catch(std::runtime_error& err) {
-    std::cout << err.what() << std::endl;
+  // No udev lookups here, the stable id already identified the
+  // device, this just guards against a different model behind it
+  char name_c_str[1024];
+  uint8_t num_axis   = 0;
+  uint8_t num_button = 0;
+  if (ioctl(tmp_fd, JSIOCGNAME(sizeof(name_c_str)), name_c_str) < 0 ||
+      ioctl(tmp_fd, JSIOCGAXES, &num_axis) < 0 ||
+      ioctl(tmp_fd, JSIOCGBUTTONS, &num_button) < 0)
+  {
+    m_verbose and std::cout << "could not query " << filename_ << std::endl;
+    close(tmp_fd);
     return false;
   }
 
+  if (orig_name != name_c_str)
+  {
+    m_verbose and std::cout << "name mismatch"  << std::endl;
+    close(tmp_fd);
+    return false;
+  }
+
+  if (num_axis != axis_count || num_button != button_count)
+  {
+    m_verbose and std::cout << "axis/button count mismatch"  << std::endl;
+    close(tmp_fd);
+    return false;
+  }
+
+  connection.disconnect();
+  close(fd);
+
+  fd = tmp_fd;
+  filename = filename_;
+  js_id = get_js_dev_id_from_filename(filename);
+  // the kernel starts over with a new device, and a profile might
+  // have been applied to it
+  calibration_dirty = true;
+  axis_mapping_dirty = true;
+  connect_js();
+
   return true;
 }
 
+bool
+Joystick::update_config()
+{
+  if (usb_id.empty())
+    return false;
+
+  std::shared_ptr<const JoystickConfig> new_cfg = get_config_for_device(usb_id, sdl_guid);
+  // unchanged models keep their config instance across reloads
+  if (new_cfg == js_cfg)
+    return false;
 
-std::pair<std::string, std::string>
-Joystick::get_usb_id_pair_from_udev()
+  // a file that was saved without changes parses to the same config,
+  // take the new instance anyway so it's the one the registry has
+  bool changed = *new_cfg != *js_cfg;
+  js_cfg  = new_cfg;
+  js_type = get_js_type_from_config(*js_cfg);
+  return changed;
+}
+
+std::string
+Joystick::lookup_stable_id(const std::string& filename, const std::string& js_id)
 {
-    struct udev *udev = udev_new();
-    if (udev) {
-      struct udev_device *input_dev = udev_device_new_from_subsystem_sysname(udev, "input", js_id.c_str());
-      struct udev_device *dev = udev_device_get_parent_with_subsystem_devtype(input_dev, "usb", "usb_device");
-      if (!dev)
-      {
-        std::cout << filename.c_str() << std::endl;
-        std::cout << "udev: Unable to find parent USB device" << std::endl;
-      }
-      else
+  return get_udev_info(filename, js_id).stable_id;
+}
+
+Joystick::UdevInfo
+Joystick::get_udev_info(const std::string& filename, const std::string& js_id)
+{
+  UdevInfo info;
+
+  struct udev *udev = udev_new();
+  if (!udev)
+  {
+    std::cout << "udev: Cannot create udev" << std::endl;
+    return info;
+  }
+
+  struct udev_device *input_dev = udev_device_new_from_subsystem_sysname(udev, "input", js_id.c_str());
+  if (!input_dev)
+  {
+    std::cout << filename.c_str() << std::endl;
+    std::cout << "udev: Unable to find input device" << std::endl;
+  }
+  else
+  {
+    info.stable_id = get_udev_stable_id(input_dev);
+    info.syspath = udev_device_get_syspath(input_dev);
+
+    // the input device above jsX carries the ids SDL builds its GUID from
+    struct udev_device *parent = udev_device_get_parent_with_subsystem_devtype(input_dev, "input", nullptr);
+    if (parent)
+    {
+      const char* ids[4] = {
+        udev_device_get_sysattr_value(parent, "id/bustype"),
+        udev_device_get_sysattr_value(parent, "id/vendor"),
+        udev_device_get_sysattr_value(parent, "id/product"),
+        udev_device_get_sysattr_value(parent, "id/version")
+      };
+      if (ids[0] && ids[1] && ids[2] && ids[3])
       {
-        std::string tmp_vendor_id;
-        std::string tmp_product_id;
-        tmp_vendor_id = udev_device_get_sysattr_value(dev, "idVendor");
-        tmp_product_id = udev_device_get_sysattr_value(dev, "idProduct");
-        // usb_id = vendor_id + ":" + product_id;
-        udev_device_unref(input_dev);
-        udev_unref(udev);
-        return {tmp_vendor_id, tmp_product_id};
+        SdlGuid guid;
+        guid.bus     = strtoul(ids[0], nullptr, 16);
+        guid.vendor  = strtoul(ids[1], nullptr, 16);
+        guid.product = strtoul(ids[2], nullptr, 16);
+        guid.version = strtoul(ids[3], nullptr, 16);
+        info.sdl_guid = format_sdl_guid(guid);
       }
-      udev_unref(udev);
+    }
+
+    struct udev_device *dev = udev_device_get_parent_with_subsystem_devtype(input_dev, "usb", "usb_device");
+    if (!dev)
+    {
+      std::cout << filename.c_str() << std::endl;
+      std::cout << "udev: Unable to find parent USB device" << std::endl;
     }
     else
     {
-      std::cout << "udev: Cannot create udev" << std::endl;
+      const char* tmp_vendor_id  = udev_device_get_sysattr_value(dev, "idVendor");
+      const char* tmp_product_id = udev_device_get_sysattr_value(dev, "idProduct");
+      info.vendor_id  = tmp_vendor_id  ? tmp_vendor_id  : "";
+      info.product_id = tmp_product_id ? tmp_product_id : "";
     }
-    return {};
+    udev_device_unref(input_dev);
+  }
+
+  udev_unref(udev);
+
+  return info;
 }
 
 bool
@@ -230,9 +350,11 @@ Joystick::on_in(Glib::IOCondition cond)
 void
 Joystick::update()
 {
-  struct js_event event;
+  // joydev hands out as many queued events as fit, so a busy device
+  // doesn't cost a main loop iteration per event
+  struct js_event events[64];
 
-  ssize_t len = read(fd, &event, sizeof(event));
+  ssize_t len = read(fd, events, sizeof(events));
 
   if (len < 0)
   {
@@ -240,18 +362,25 @@ Joystick::update()
     str << filename << ": " << strerror(errno);
     throw std::runtime_error(str.str());
   }
-  else if (len == sizeof(event))
+  else if (len > 0 && len % sizeof(struct js_event) == 0)
   { // ok
-    if (event.type & JS_EVENT_AXIS)
-    {
-      //std::cout << "Axis: " << (int)event.number << " -> " << (int)event.value << std::endl;
-      axis_state[event.number] = event.value;
-      axis_move(event.number, event.value);
-    }
-    else if (event.type & JS_EVENT_BUTTON)
+    for(size_t i = 0; i < len / sizeof(struct js_event); ++i)
     {
-      //std::cout << "Button: " << (int)event.number << " -> " << (int)event.value << std::endl;
-      button_move(event.number, event.value);
+      const struct js_event& event = events[i];
+      event_time = event.time;
+      event_is_initial = (event.type & JS_EVENT_INIT) != 0;
+
+      if (event.type & JS_EVENT_AXIS)
+      {
+        //std::cout << "Axis: " << (int)event.number << " -> " << (int)event.value << std::endl;
+        axis_state[event.number] = event.value;
+        axis_move(event.number, event.value);
+      }
+      else if (event.type & JS_EVENT_BUTTON)
+      {
+        //std::cout << "Button: " << (int)event.number << " -> " << (int)event.value << std::endl;
+        button_move(event.number, event.value);
+      }
     }
   }
   else
@@ -259,36 +388,134 @@ Joystick::update()
     throw std::runtime_error("Joystick::update(): unknown read error");
   }
 }
-
+
+namespace {
+
+bool device_file_less(const std::string& lhs, const std::string& rhs)
+{
+  // natural order for the trailing number: js2 < js10
+  if (lhs.size() != rhs.size())
+    return lhs.size() < rhs.size();
+  else
+    return lhs < rhs;
+}
+
+/** Fallback for when udev isn't available, lists /dev/input/ for
+    files starting with \a prefix */
+std::vector<std::string> scan_dev_input(const std::string& prefix)
+{
+  std::vector<std::string> filenames;
+
+  DIR* dir = opendir("/dev/input");
+  if (dir)
+  {
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != nullptr)
+    {
+      if (strncmp(entry->d_name, prefix.c_str(), prefix.size()) == 0)
+      {
+        filenames.push_back(std::string("/dev/input/") + entry->d_name);
+      }
+    }
+    closedir(dir);
+  }
+
+  std::sort(filenames.begin(), filenames.end(), device_file_less);
+  return filenames;
+}
+
+} // namespace
+
+std::vector<std::string>
+Joystick::get_joystick_filenames()
+{
+  struct udev* udev = udev_new();
+  if (!udev)
+  {
+    std::cout << "udev: Cannot create udev" << std::endl;
+    return scan_dev_input("js");
+  }
+
+  std::vector<std::string> filenames;
+
+  struct udev_enumerate* enumerate = udev_enumerate_new(udev);
+  udev_enumerate_add_match_subsystem(enumerate, "input");
+  udev_enumerate_add_match_sysname(enumerate, "js*");
+  udev_enumerate_scan_devices(enumerate);
+
+  struct udev_list_entry* entry;
+  udev_list_entry_foreach(entry, udev_enumerate_get_list_entry(enumerate))
+  {
+    struct udev_device* dev = udev_device_new_from_syspath(udev, udev_list_entry_get_name(entry));
+    if (dev)
+    {
+      const char* devnode = udev_device_get_devnode(dev);
+      if (devnode)
+      {
+        filenames.push_back(devnode);
+      }
+      udev_device_unref(dev);
+    }
+  }
+
+  udev_enumerate_unref(enumerate);
+  udev_unref(udev);
+
+  std::sort(filenames.begin(), filenames.end(), device_file_less);
+  return filenames;
+}
+
+JoystickDescription
+Joystick::probe(const std::string& filename, const std::string& js_id)
+{
+  int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0)
+  {
+    std::ostringstream str;
+    str << filename << ": " << strerror(errno);
+    throw std::runtime_error(str.str());
+  }
+
+  DeviceMetadataCache& cache = DeviceMetadataCache::instance();
+  DeviceMetadata metadata;
+  if (!cache.lookup(filename, metadata))
+  {
+    unsigned long long seqnum = cache.get_seqnum();
+    try {
+      read_metadata(fd, filename, js_id, metadata);
+    } catch(...) {
+      close(fd);
+      throw;
+    }
+    cache.store(metadata, seqnum);
+  }
+  close(fd);
+
+  return JoystickDescription(metadata.filename,
+                             metadata.name,
+                             metadata.js_id,
+                             metadata.vendor_id,
+                             metadata.product_id,
+                             metadata.usb_id,
+                             metadata.axis_count,
+                             metadata.button_count,
+                             metadata.syspath);
+}
+
 std::vector<JoystickDescription>
 Joystick::get_joysticks()
 {
   std::vector<JoystickDescription> joysticks;
 
-  for(int i = 0; i < 32; ++i)
+  for(const auto& filename : get_joystick_filenames())
   {
     try
     {
-      std::string js_id = std::string("js") + std::to_string(i);;
-      std::string str = std::string("/dev/input/") + js_id;
-
-      if (Glib::file_test(str, Glib::FILE_TEST_EXISTS))
-      {
-      Joystick joystick(str, js_id);
-
-      joysticks.push_back(JoystickDescription(joystick.get_filename(),
-                                              joystick.get_name(),
-                                              joystick.get_js_id(),
-                                              joystick.get_vendor_id(),
-                                              joystick.get_product_id(),
-                                              joystick.get_usb_id(),
-                                              joystick.get_axis_count(),
-                                              joystick.get_button_count()));
-      }
+      joysticks.push_back(probe(filename, get_js_dev_id_from_filename(filename)));
     }
     catch(std::exception& err)
     {
-      // ok
+      std::cout << err.what() << std::endl;
     }
   }
 
@@ -332,23 +559,37 @@ Joystick::CalibrationData corr2cal(const struct js_corr& corr_)
   return data;
 }
 
-std::vector<Joystick::CalibrationData>
-Joystick::get_calibration()
+const std::vector<struct js_corr>&
+Joystick::get_corr()
 {
-  std::vector<struct js_corr> corr(get_axis_count());
-
-  if (ioctl(fd, JSIOCGCORR, &*corr.begin()) < 0)
-  {
-    std::ostringstream str;
-    str << filename << ": " << strerror(errno);
-    throw std::runtime_error(str.str());
-  }
-  else
+  if (calibration_dirty)
   {
-    std::vector<CalibrationData> data;
-    std::transform(corr.begin(), corr.end(), std::back_inserter(data), corr2cal);
-    return data;
+    corr_cache.resize(get_axis_count());
+    if (ioctl(fd, JSIOCGCORR, corr_cache.data()) < 0)
+    {
+      std::ostringstream str;
+      str << filename << ": " << strerror(errno);
+      throw std::runtime_error(str.str());
+    }
+    update_calibration_cache();
   }
+
+  return corr_cache;
+}
+
+const std::vector<Joystick::CalibrationData>&
+Joystick::get_calibration()
+{
+  get_corr();
+  return calibration_cache;
+}
+
+void
+Joystick::update_calibration_cache()
+{
+  calibration_cache.resize(corr_cache.size());
+  std::transform(corr_cache.begin(), corr_cache.end(), calibration_cache.begin(), corr2cal);
+  calibration_dirty = false;
 }
 
 struct js_corr cal2corr(const Joystick::CalibrationData& data)
@@ -384,11 +625,9 @@ struct js_corr cal2corr(const Joystick::CalibrationData& data)
 }
 
 void
-Joystick::set_calibration(const std::vector<CalibrationData>& data)
+Joystick::set_corr(const std::vector<struct js_corr>& corr)
 {
-  std::vector<struct js_corr> corr;
-
-  std::transform(data.begin(), data.end(), std::back_inserter(corr), cal2corr);
+  assert((int)corr.size() == axis_count);
 
   if (ioctl(fd, JSIOCSCORR, &*corr.begin()) < 0)
   {
@@ -396,6 +635,24 @@ Joystick::set_calibration(const std::vector<CalibrationData>& data)
     str << filename << ": " << strerror(errno);
     throw std::runtime_error(str.str());
   }
+
+  // the kernel takes the values as they are, so the snapshot can
+  // be updated without reading them back
+  if (&corr != &corr_cache)
+  {
+    corr_cache.assign(corr.begin(), corr.end());
+  }
+  update_calibration_cache();
+}
+
+void
+Joystick::set_calibration(const std::vector<CalibrationData>& data)
+{
+  std::vector<struct js_corr> corr;
+
+  std::transform(data.begin(), data.end(), std::back_inserter(corr), cal2corr);
+
+  set_corr(corr);
 }
 
 void
@@ -444,22 +701,24 @@ Joystick::get_button_mapping()
   }
 }
 
-std::vector<int>
+const std::vector<int>&
 Joystick::get_axis_mapping()
 {
-  uint8_t axismap[ABS_MAX + 1];
-  if (ioctl(fd, JSIOCGAXMAP, axismap) < 0)
+  if (axis_mapping_dirty)
   {
-    std::ostringstream str;
-    str << filename << ": " << strerror(errno);
-    throw std::runtime_error(str.str());
-  }
-  else
-  {
-    std::vector<int> mapping;
-    std::copy(axismap, axismap + axis_count, std::back_inserter(mapping));
-    return mapping;
+    uint8_t axismap[ABS_MAX + 1];
+    if (ioctl(fd, JSIOCGAXMAP, axismap) < 0)
+    {
+      std::ostringstream str;
+      str << filename << ": " << strerror(errno);
+      throw std::runtime_error(str.str());
+    }
+
+    axis_mapping_cache.assign(axismap, axismap + axis_count);
+    axis_mapping_dirty = false;
   }
+
+  return axis_mapping_cache;
 }
 
 void
@@ -499,8 +758,10 @@ Joystick::set_axis_mapping(const std::vector<int>& mapping)
 {
   assert((int)mapping.size() == axis_count);
 
+  // the kernel copies the whole array, don't hand it stack garbage
+  // for the unused tail
   uint8_t axismap[ABS_MAX + 1];
-
+  memset(axismap, 0, sizeof(axismap));
   std::copy(mapping.begin(), mapping.end(), axismap);
 
   if (ioctl(fd, JSIOCSAXMAP, axismap) < 0)
@@ -509,38 +770,82 @@ Joystick::set_axis_mapping(const std::vector<int>& mapping)
     str << filename << ": " << strerror(errno);
     throw std::runtime_error(str.str());
   }
+
+  axis_mapping_cache.assign(mapping.begin(), mapping.end());
+  axis_mapping_dirty = false;
 }
 
 void
-Joystick::correct_calibration(const std::vector<int>& mapping_old, const std::vector<int>& mapping_new)
+Joystick::remap_axes(const std::vector<int>& mapping)
 {
-  int axes[ABS_MAX + 1]; // axes[name] -> old_idx
-  for(std::vector<int>::const_iterator i = mapping_old.begin(); i != mapping_old.end(); ++i)
+  RemapResult result;
+  try
   {
-    axes[*i] = i - mapping_old.begin();
+    result = write_remap(get_corr(), get_axis_mapping(), mapping,
+                         [this](const std::vector<int>& m) { set_axis_mapping(m); },
+                         [this](const std::vector<struct js_corr>& c) { set_corr(c); });
   }
-
-  std::vector<CalibrationData> callib_old = get_calibration();
-  std::vector<CalibrationData> callib_new;
-  for(std::vector<int>::const_iterator i = mapping_new.begin(); i != mapping_new.end(); ++i)
+  catch(...)
   {
-    callib_new.push_back(callib_old[axes[*i]]);
+    // putting the old map back may have failed too
+    axis_mapping_dirty = true;
+    throw;
   }
 
-  set_calibration(callib_new);
+  if (result == REMAP_INVALID)
+  {
+    throw std::runtime_error(filename + ": axis mapping is not a permutation of the current one");
+  }
 }
 
 std::string
 Joystick::get_evdev() const
 {
-  // See /usr/share/doc/linux-doc-2.6.28/devices.txt.gz
-  for(int i = 0; i < 32; ++i)
+  // The jsX and its eventX share the same parent input device
+  struct udev* udev = udev_new();
+  if (udev)
   {
-    std::ostringstream out;
-    out << "/dev/input/event" << i;
+    std::string evdev;
 
+    struct udev_device* js_dev = udev_device_new_from_subsystem_sysname(udev, "input", js_id.c_str());
+    struct udev_device* input_dev = js_dev ? udev_device_get_parent(js_dev) : nullptr;
+    if (input_dev)
+    {
+      struct udev_enumerate* enumerate = udev_enumerate_new(udev);
+      udev_enumerate_add_match_parent(enumerate, input_dev);
+      udev_enumerate_add_match_sysname(enumerate, "event*");
+      udev_enumerate_scan_devices(enumerate);
+
+      struct udev_list_entry* entry = udev_enumerate_get_list_entry(enumerate);
+      if (entry)
+      {
+        struct udev_device* dev = udev_device_new_from_syspath(udev, udev_list_entry_get_name(entry));
+        if (dev)
+        {
+          const char* devnode = udev_device_get_devnode(dev);
+          if (devnode)
+            evdev = devnode;
+          udev_device_unref(dev);
+        }
+      }
+
+      udev_enumerate_unref(enumerate);
+    }
+
+    if (js_dev)
+      udev_device_unref(js_dev);
+    udev_unref(udev);
+
+    if (!evdev.empty())
+      return evdev;
+  }
+
+  // No udev, so fall back to matching the device name
+  // See /usr/share/doc/linux-doc-2.6.28/devices.txt.gz
+  for(const auto& filename_ : scan_dev_input("event"))
+  {
     int evdev_fd;
-    if ((evdev_fd = open(out.str().c_str(), O_RDONLY)) < 0)
+    if ((evdev_fd = open(filename_.c_str(), O_RDONLY)) < 0)
     {
       // ignore
     }
@@ -549,7 +854,7 @@ Joystick::get_evdev() const
       char evdev_name[256];
       if (ioctl(evdev_fd, EVIOCGNAME(sizeof(evdev_name)), evdev_name) < 0)
       {
-        std::cout << out.str() << ": " << strerror(errno) << std::endl;
+        std::cout << filename_ << ": " << strerror(errno) << std::endl;
       }
       else
       {
@@ -557,7 +862,7 @@ Joystick::get_evdev() const
         {
           // Found a device that matches, so return it
           close(evdev_fd);
-          return out.str();
+          return filename_;
         }
       }
 
@@ -31,6 +31,7 @@
 
 class XMLReader;
 class XMLWriter;
+struct DeviceMetadata;
 
 std::string get_js_dev_id_from_filename(const std::string& filename_);
 
@@ -57,28 +58,67 @@ private:
   std::string vendor_id;
   std::string product_id;
   std::string usb_id;
+  std::string stable_id;
+  std::string sdl_guid;
   int axis_count;
   int button_count;
 
+  struct UdevInfo {
+    std::string vendor_id;
+    std::string product_id;
+    std::string stable_id;
+    std::string syspath;
+    std::string sdl_guid;
+  };
+
   void connect_js();
   int get_new_joystick_fd();
-  std::pair<std::string, std::string> get_usb_id_pair_from_udev();
+  static UdevInfo get_udev_info(const std::string& filename, const std::string& js_id);
+
+  /** Reads the metadata of the already opened joystick \a fd through
+      ioctl and udev, use DeviceMetadataCache::lookup() first */
+  static void read_metadata(int fd, const std::string& filename, const std::string& js_id,
+                            DeviceMetadata& metadata);
 
   std::vector<int> axis_state;
   std::vector<CalibrationData> orig_calibration_data;
 
+  // What the kernel has, as last read or written through this object.
+  // Only read again when it might have been changed from elsewhere.
+  std::vector<struct js_corr> corr_cache;
+  std::vector<CalibrationData> calibration_cache;
+  bool calibration_dirty;
+  std::vector<int> axis_mapping_cache;
+  bool axis_mapping_dirty;
+
+  void update_calibration_cache();
+
   sigc::connection connection;
 
+  // the event that is being dispatched
+  uint32_t event_time;
+  bool event_is_initial;
+
 public:
   Joystick(const std::string& filename, const std::string& js_id);
   ~Joystick();
 
-  JoystickConfig js_cfg;
+  /** Shared with every other device of the same model, never nullptr */
+  std::shared_ptr<const JoystickConfig> js_cfg;
   int get_fd() const { return fd; }
 
   void update();
   bool on_in(Glib::IOCondition cond);
-  bool reconnected();
+
+  /** Rebinds this Joystick to \a filename_, which might differ from
+      the old device file when the device came back under a different
+      jsX. Only checks that the device looks the same, the caller is
+      expected to have matched the stable id. */
+  bool reconnect(const std::string& filename_);
+
+  /** Looks up js_cfg and js_type again after the config registry got
+      reloaded, returns true when they changed */
+  bool update_config();
 
   std::string get_filename() const    { return filename; }
   Glib::ustring get_name() const      { return name; }
@@ -87,6 +127,9 @@ public:
   std::string get_vendor_id() const   { return vendor_id; }
   std::string get_product_id() const  { return product_id; }
   std::string get_usb_id() const      { return usb_id; }
+  std::string get_stable_id() const   { return stable_id; }
+  /** GUID SDL would use for the device, for gamecontrollerdb lookups */
+  std::string get_sdl_guid() const    { return sdl_guid; }
   int get_axis_count() const          { return axis_count; }
   int get_button_count() const        { return button_count; }
 
@@ -98,26 +141,71 @@ public:
   sigc::signal<void, int, int>  axis_move;
   sigc::signal<void, int, bool> button_move;
 
+  /** Kernel timestamp in milliseconds of the event axis_move or
+      button_move is currently emitted for, and whether it is one of
+      the synthetic events joydev sends for the initial state */
+  uint32_t get_event_time() const     { return event_time; }
+  bool is_initial_event() const       { return event_is_initial; }
+
   int get_axis_state(int id);
 
   static std::vector<JoystickDescription> get_joysticks();
 
-  std::vector<CalibrationData> get_calibration();
+  /** Device files of the joysticks that are currently present */
+  static std::vector<std::string> get_joystick_filenames();
+
+  /** Reads the description of a joystick without keeping the device
+      open or hooking it into the main loop, so unlike the constructor
+      it is safe to call from a worker thread. Throws on error. */
+  static JoystickDescription probe(const std::string& filename, const std::string& js_id);
+
+  /** Stable id of the device behind \a filename as udev reports it,
+      see get_udev_stable_id() */
+  static std::string lookup_stable_id(const std::string& filename, const std::string& js_id);
+
+  /** The calibration of the device. Served from a snapshot that is
+      kept up to date by the setters, the device is only asked again
+      after a reconnect or refresh_calibration(). The reference stays
+      valid until the calibration is changed. */
+  const std::vector<CalibrationData>& get_calibration();
   void set_calibration(const std::vector<CalibrationData>& data);
+
+  /** The calibration as the kernel stores it, one js_corr per axis,
+      unlike CalibrationData this round-trips without rounding */
+  const std::vector<struct js_corr>& get_corr();
+  void set_corr(const std::vector<struct js_corr>& corr);
   void reset_calibration();
 
+  /** Reads the calibration and the axis mapping from the device again
+      when next asked for, for when something else may have changed
+      them */
+  void refresh_calibration() { calibration_dirty = true; axis_mapping_dirty = true; }
+
+  /** The calibration the device had when it was first opened */
+  const std::vector<CalibrationData>& get_orig_calibration() const { return orig_calibration_data; }
+
   /** Clears all calibration data, note that this will mean raw USB
       input values, not values scaled to -32767/32767 */
   void clear_calibration();
 
   std::vector<int> get_button_mapping();
-  std::vector<int> get_axis_mapping();
+
+  /** The ABS_* code of each axis, served from a snapshot like
+      get_calibration() */
+  const std::vector<int>& get_axis_mapping();
 
   void set_button_mapping(const std::vector<int>& mapping);
+
+  /** Writes the axis map as is, the calibration stays with the axis
+      index, see remap_axes() */
   void set_axis_mapping(const std::vector<int>& mapping);
 
-  /** Corrects calibration data after remaping axes */
-  void correct_calibration(const std::vector<int>& mapping_old, const std::vector<int>& mapping_new);
+  /** Moves the axes to \a mapping and takes their calibration along.
+      Both are computed from the snapshots and written back to back,
+      nothing is written when \a mapping is the current one. Throws
+      without writing anything when \a mapping isn't a permutation of
+      the current mapping. */
+  void remap_axes(const std::vector<int>& mapping);
 
   void write(XMLWriter& out);
   void load(const XMLReader& reader);
@@ -131,6 +219,11 @@ private:
   Joystick(const Joystick&);
   Joystick& operator=(const Joystick&);
 };
+
+/** Conversion between CalibrationData and the joydev js_corr
+    coefficients, see the "Apply coef" notes in TODO */
+struct js_corr cal2corr(const Joystick::CalibrationData& data);
+Joystick::CalibrationData corr2cal(const struct js_corr& corr);
 
 #endif
 
@@ -18,11 +18,15 @@
 
 #include <iostream>
 #include <assert.h>
+#include <algorithm>
+#include <iterator>
 #include <gtkmm/spinbutton.h>
 #include <gtkmm/stock.h>
+#include <glibmm/main.h>
 
 #include "joystick.hpp"
 #include "calibrate_maximum_dialog.hpp"
+#include "linearity_dialog.hpp"
 #include "joystick_calibration_widget.hpp"
 
 JoystickCalibrationWidget::JoystickCalibrationWidget(Joystick& joystick)
@@ -36,7 +40,16 @@ JoystickCalibrationWidget::JoystickCalibrationWidget(Joystick& joystick)
     axis_frame("Axes"),
     axis_table(joystick.get_axis_count() + 1, 5),
     buttonbox(Gtk::BUTTONBOX_SPREAD),
-    calibration_button("Start Calibration")
+    calibration_button("Start Calibration"),
+    linearity_button("Linearity"),
+    preview_button("Preview without applying"),
+    preview_engine(),
+    raw_values(joystick.get_axis_count()),
+    axis_connection(),
+    apply_timeout(),
+    applied_corr(),
+    rollback_corr(),
+    updating(false)
 {
   set_border_width(5);
   axis_frame.set_border_width(5);
@@ -47,9 +60,15 @@ JoystickCalibrationWidget::JoystickCalibrationWidget(Joystick& joystick)
   get_vbox()->pack_start(label, Gtk::PACK_SHRINK);
 
   calibration_button.signal_clicked().connect(sigc::mem_fun(this, &JoystickCalibrationWidget::on_calibrate));
+  linearity_button.signal_clicked().connect(sigc::mem_fun(this, &JoystickCalibrationWidget::on_linearity));
+  linearity_button.set_tooltip_text("Check an axis for a nonlinear response, flat spots and missing values");
+  preview_button.signal_toggled().connect(sigc::mem_fun(this, &JoystickCalibrationWidget::on_preview));
+  preview_button.set_tooltip_text("Show what the calibration does to the raw input without writing it to the device");
 
   buttonbox.set_border_width(5);
   buttonbox.add(calibration_button);
+  buttonbox.add(linearity_button);
+  buttonbox.add(preview_button);
   get_vbox()->pack_start(buttonbox, Gtk::PACK_SHRINK);
 
   axis_table.attach(*Gtk::manage(new Gtk::Label("Axes")), 0, 1, 0, 1);
@@ -61,6 +80,7 @@ JoystickCalibrationWidget::JoystickCalibrationWidget(Joystick& joystick)
   axis_table.attach(*Gtk::manage(new Gtk::Label("RangeMax")), 4, 5, 0, 1);
 
   axis_table.attach(*Gtk::manage(new Gtk::Label("Invert")), 5, 6, 0, 1);
+  axis_table.attach(*Gtk::manage(new Gtk::Label("Output")), 6, 7, 0, 1);
 
   axis_table.set_col_spacing(2, 8);
   for(int i = 0; i < joystick.get_axis_count(); ++i)
@@ -73,11 +93,11 @@ JoystickCalibrationWidget::JoystickCalibrationWidget(Joystick& joystick)
     Gtk::SpinButton&  range_max  = *Gtk::manage(new Gtk::SpinButton((data.range_max  = Gtk::Adjustment::create(0, -32768, 32767))));
     Gtk::CheckButton& invert     = *(data.invert = Gtk::manage(new Gtk::CheckButton()));
 
-    center_min.signal_value_changed().connect(sigc::mem_fun(this, &JoystickCalibrationWidget::on_apply));
-    center_max.signal_value_changed().connect(sigc::mem_fun(this, &JoystickCalibrationWidget::on_apply));
-    range_min.signal_value_changed().connect(sigc::mem_fun(this, &JoystickCalibrationWidget::on_apply));
-    range_max.signal_value_changed().connect(sigc::mem_fun(this, &JoystickCalibrationWidget::on_apply));
-    invert.signal_clicked().connect(sigc::mem_fun(this, &JoystickCalibrationWidget::on_apply));
+    center_min.signal_value_changed().connect(sigc::mem_fun(this, &JoystickCalibrationWidget::on_changed));
+    center_max.signal_value_changed().connect(sigc::mem_fun(this, &JoystickCalibrationWidget::on_changed));
+    range_min.signal_value_changed().connect(sigc::mem_fun(this, &JoystickCalibrationWidget::on_changed));
+    range_max.signal_value_changed().connect(sigc::mem_fun(this, &JoystickCalibrationWidget::on_changed));
+    invert.signal_clicked().connect(sigc::mem_fun(this, &JoystickCalibrationWidget::on_changed));
 
     center_min.set_tooltip_text("The minimal value of the dead zone");
     center_max.set_tooltip_text("The maximum value of the dead zone");
@@ -97,10 +117,17 @@ JoystickCalibrationWidget::JoystickCalibrationWidget(Joystick& joystick)
     axis_table.attach(range_max, 4, 5, i+1, i+2);
 
     axis_table.attach(invert, 5, 6, i+1, i+2, Gtk::SHRINK, Gtk::SHRINK);
+
+    Gtk::ProgressBar& output = *Gtk::manage(new Gtk::ProgressBar());
+    output.set_fraction(0.5);
+    axis_table.attach(output, 6, 7, i+1, i+2, Gtk::FILL|Gtk::EXPAND, Gtk::EXPAND);
+    output_bars.push_back(&output);
   }
 
   add_button(Gtk::Stock::REVERT_TO_SAVED,  2);
   add_button("Raw Events", 1);
+  add_button(Gtk::Stock::UNDO, 4)->set_tooltip_text("Go back to the calibration from when Apply was last pressed");
+  add_button(Gtk::Stock::APPLY, 3);
   Gtk::Widget* close_button = add_button(Gtk::Stock::CLOSE, 0);
 
   scroll.add(axis_table);
@@ -114,14 +141,52 @@ JoystickCalibrationWidget::JoystickCalibrationWidget(Joystick& joystick)
 
   close_button->grab_focus();
 
-  update_with(joystick.get_calibration());
+  load_from_device();
+  rollback_corr = applied_corr;
+
+  axis_connection = joystick.axis_move.connect(sigc::mem_fun(this, &JoystickCalibrationWidget::on_axis_move));
+  for(int i = 0; i < joystick.get_axis_count(); ++i)
+  {
+    on_axis_move(i, joystick.get_axis_state(i));
+  }
+}
+
+JoystickCalibrationWidget::~JoystickCalibrationWidget()
+{
+  axis_connection.disconnect();
+
+  // write what is pending, and don't leave the device reporting raw
+  // values after a preview
+  bool pending = apply_timeout.connected();
+  apply_timeout.disconnect();
+  if (pending || preview_button.get_active())
+  {
+    try
+    {
+      joystick.set_corr(get_corr());
+    }
+    catch(std::exception& err)
+    {
+      std::cout << err.what() << std::endl;
+    }
+  }
 }
 
 void
 JoystickCalibrationWidget::on_clear()
 {
-  joystick.clear_calibration();
-  update_with(joystick.get_calibration());
+  if (preview_button.get_active())
+  {
+    // all zero is no calibration, see cal2corr()
+    Joystick::CalibrationData none = { false, false, 0, 0, 0, 0 };
+    update_with(std::vector<Joystick::CalibrationData>(calibration_data.size(), none));
+  }
+  else
+  {
+    apply_timeout.disconnect();
+    joystick.clear_calibration();
+    load_from_device();
+  }
 }
 
 void
@@ -140,7 +205,20 @@ JoystickCalibrationWidget::update_with(const std::vector<Joystick::CalibrationDa
 }
 
 void
-JoystickCalibrationWidget::on_apply()
+JoystickCalibrationWidget::load_from_device()
+{
+  applied_corr = joystick.get_corr();
+
+  std::vector<Joystick::CalibrationData> data;
+  std::transform(applied_corr.begin(), applied_corr.end(), std::back_inserter(data), corr2cal);
+
+  updating = true;
+  update_with(data);
+  updating = false;
+}
+
+std::vector<Joystick::CalibrationData>
+JoystickCalibrationWidget::get_data() const
 {
   std::vector<Joystick::CalibrationData> data(calibration_data.size());
 
@@ -154,16 +232,179 @@ JoystickCalibrationWidget::on_apply()
     data[i].range_max  = calibration_data[i].range_max->get_value();
   }
 
-  joystick.set_calibration(data);
+  return data;
+}
+
+std::vector<struct js_corr>
+JoystickCalibrationWidget::get_corr() const
+{
+  std::vector<Joystick::CalibrationData> data = get_data();
+  std::vector<struct js_corr> corr;
+  std::transform(data.begin(), data.end(), std::back_inserter(corr), cal2corr);
+  return corr;
+}
+
+void
+JoystickCalibrationWidget::on_changed()
+{
+  // holding an arrow key on a spin button changes the value dozens of
+  // times a second, each JSIOCSCORR resets the axis state in the kernel
+  if (!updating && !apply_timeout.connected())
+  {
+    apply_timeout = Glib::signal_timeout().connect(sigc::mem_fun(this, &JoystickCalibrationWidget::on_apply_timeout),
+                                                   1000 / 60);
+  }
+}
+
+bool
+JoystickCalibrationWidget::on_apply_timeout()
+{
+  flush();
+  return false;
+}
+
+void
+JoystickCalibrationWidget::flush()
+{
+  apply_timeout.disconnect();
+
+  std::vector<struct js_corr> corr = get_corr();
+  if (corr_equal(corr, applied_corr))
+    return;
+
+  if (preview_button.get_active())
+  {
+    preview_engine.set(corr);
+    applied_corr = corr;
+    update_output();
+  }
+  else
+  {
+    try
+    {
+      joystick.set_corr(corr);
+      applied_corr = corr;
+    }
+    catch(std::exception& err)
+    {
+      std::cout << err.what() << std::endl;
+      rollback();
+    }
+  }
+}
+
+void
+JoystickCalibrationWidget::commit()
+{
+  if (preview_button.get_active())
+  {
+    // writes the calibration to the device
+    preview_button.set_active(false);
+  }
+  else
+  {
+    flush();
+  }
+  rollback_corr = applied_corr;
+}
+
+void
+JoystickCalibrationWidget::rollback()
+{
+  apply_timeout.disconnect();
+
+  if (!preview_button.get_active())
+  {
+    try
+    {
+      joystick.set_corr(rollback_corr);
+    }
+    catch(std::exception& err)
+    {
+      std::cout << err.what() << std::endl;
+    }
+  }
+
+  std::vector<Joystick::CalibrationData> data;
+  std::transform(rollback_corr.begin(), rollback_corr.end(), std::back_inserter(data), corr2cal);
+
+  updating = true;
+  update_with(data);
+  updating = false;
+
+  applied_corr = rollback_corr;
+  if (preview_button.get_active())
+  {
+    preview_engine.set(applied_corr);
+    update_output();
+  }
+}
+
+void
+JoystickCalibrationWidget::on_preview()
+{
+  apply_timeout.disconnect();
+
+  // the engine needs the raw values, the edits stay in userspace
+  // until the preview is switched off again, which applies them
+  if (preview_button.get_active())
+  {
+    joystick.clear_calibration();
+  }
+  applied_corr.clear();
+  flush();
+}
+
+void
+JoystickCalibrationWidget::on_axis_move(int number, int value)
+{
+  if (number < 0 || number >= static_cast<int>(raw_values.size()))
+    return;
+
+  raw_values[number] = value;
+  if (preview_button.get_active())
+    value = preview_engine.correct(number, value);
+
+  output_bars[number]->set_fraction((value + 32767) / (double)(2*32767));
+}
+
+void
+JoystickCalibrationWidget::update_output()
+{
+  std::vector<int> output(raw_values.size());
+  preview_engine.correct_all(raw_values.data(), output.data());
+  for(size_t i = 0; i < output.size(); ++i)
+  {
+    output_bars[i]->set_fraction((output[i] + 32767) / (double)(2*32767));
+  }
 }
 
 void
 JoystickCalibrationWidget::on_calibrate()
 {
+  // the wizard works on the device itself
+  preview_button.set_active(false);
+
+  flush();
+
   CalibrateMaximumDialog dialog(joystick);
   dialog.show_all();
   dialog.run();
-  update_with(joystick.get_calibration());
+  load_from_device();
+}
+
+void
+JoystickCalibrationWidget::on_linearity()
+{
+  // like the wizard, this works on the raw values of the device
+  preview_button.set_active(false);
+
+  flush();
+
+  LinearityDialog dialog(joystick);
+  dialog.show_all();
+  dialog.run();
+  load_from_device();
 }
 
 void
@@ -173,14 +414,30 @@ JoystickCalibrationWidget::on_response(int i)
   {
     hide();
   }
+  else if (i == 3)
+  {
+    commit();
+  }
+  else if (i == 4)
+  {
+    rollback();
+  }
   else if (i == 1)
   {
     on_clear();
   }
   else if (i == 2)
   {
-    joystick.reset_calibration();
-    update_with(joystick.get_calibration());
+    if (preview_button.get_active())
+    {
+      update_with(joystick.get_orig_calibration());
+    }
+    else
+    {
+      apply_timeout.disconnect();
+      joystick.reset_calibration();
+      load_from_device();
+    }
   }
 }
 
@@ -25,8 +25,10 @@
 #include <gtkmm/label.h>
 #include <gtkmm/table.h>
 #include <gtkmm/dialog.h>
+#include <gtkmm/progressbar.h>
 #include <gtkmm/scrolledwindow.h>
 
+#include "calibration_engine.hpp"
 #include "joystick.hpp"
 
 class JoystickCalibrationWidget : public Gtk::Dialog
@@ -39,6 +41,8 @@ private:
   Gtk::Table  axis_table;
   Gtk::HButtonBox buttonbox;
   Gtk::Button calibration_button;
+  Gtk::Button linearity_button;
+  Gtk::CheckButton preview_button;
   Gtk::ScrolledWindow scroll;
 
   struct CalibrationData {
@@ -50,18 +54,56 @@ private:
   };
 
   std::vector<CalibrationData> calibration_data;
+  std::vector<Gtk::ProgressBar*> output_bars;
+
+  // While previewing, the device reports raw values and the edited
+  // calibration is only applied in userspace
+  CalibrationEngine preview_engine;
+  std::vector<int> raw_values;
+  sigc::connection axis_connection;
+
+  // Edits are collected and applied at most once per frame. applied_corr
+  // is what the device (or the preview) has, rollback_corr what the
+  // device had when the dialog opened or Apply was last pressed.
+  sigc::connection apply_timeout;
+  std::vector<struct js_corr> applied_corr;
+  std::vector<struct js_corr> rollback_corr;
+  bool updating;
 
 public:
   JoystickCalibrationWidget(Joystick& joystick);
+  ~JoystickCalibrationWidget();
 
   void update_with(const std::vector<Joystick::CalibrationData>& data);
 
   void on_clear();
-  void on_apply();
   void on_response(int i) override;
   void on_calibrate();
+  void on_linearity();
+  void on_preview();
+
+  /** Applies pending edits right away and makes them the state
+      rollback() returns to */
+  void commit();
+
+  /** Drops pending edits and restores the device to the last commit
+      with a single JSIOCSCORR */
+  void rollback();
 
 private:
+  std::vector<Joystick::CalibrationData> get_data() const;
+  std::vector<struct js_corr> get_corr() const;
+
+  void on_changed();
+  bool on_apply_timeout();
+  void flush();
+
+  /** Shows what the device currently has, without writing it back */
+  void load_from_device();
+
+  void on_axis_move(int number, int value);
+  void update_output();
+
   JoystickCalibrationWidget(const JoystickCalibrationWidget&);
   JoystickCalibrationWidget& operator=(const JoystickCalibrationWidget&);
 };
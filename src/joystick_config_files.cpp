@@ -19,108 +19,710 @@
 
 
 
+#include <algorithm>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_set>
+
 #include "joystick_config_files.hpp"
-#include "main.hpp"
+#include "parallel_for.hpp"
+#include "sdl_mapping.hpp"
+#include "verbose.hpp"
+
+namespace {
+
+// only ever accessed through std::atomic_load()/std::atomic_store()
+std::shared_ptr<const JoystickConfigRegistry> joystick_configs = std::make_shared<JoystickConfigRegistry>();
+
+} // namespace
+
+namespace {
+
+std::mutex label_pool_mutex;
+
+const std::string* intern_label(const char* data, size_t len) {
+  static const std::string empty;
+  if (len == 0) return &empty;
+
+  // node based, so the strings never move
+  static std::unordered_set<std::string> pool;
+  std::lock_guard<std::mutex> lock(label_pool_mutex);
+  return &*pool.emplace(data, len).first;
+}
+
+} // namespace
+
+Label::Label() : m_str(intern_label("", 0)) {}
+Label::Label(const char* str) : m_str(intern_label(str, strlen(str))) {}
+Label::Label(const std::string& str) : m_str(intern_label(str.data(), str.size())) {}
+Label::Label(const char* data, size_t len) : m_str(intern_label(data, len)) {}
+
+std::shared_ptr<const JoystickConfigRegistry> get_joystick_configs() {
+  return std::atomic_load(&joystick_configs);
+}
+
+void set_joystick_configs(std::shared_ptr<const JoystickConfigRegistry> configs) {
+  std::atomic_store(&joystick_configs, std::move(configs));
+}
+
+bool pack_usb_id(const std::string& usb_id, uint32_t& key) {
+  if (usb_id.size() != 9 || usb_id[4] != ':') return false;
+
+  uint32_t result = 0;
+  for (size_t i = 0; i < usb_id.size(); ++i) {
+    if (i == 4) continue;
+
+    char c = usb_id[i];
+    uint32_t digit;
+    if (c >= '0' && c <= '9') digit = c - '0';
+    else if (c >= 'a' && c <= 'f') digit = c - 'a' + 10;
+    else if (c >= 'A' && c <= 'F') digit = c - 'A' + 10;
+    else return false;
 
-std::vector<JoystickConfig> joystick_configs;
+    result = (result << 4) | digit;
+  }
+
+  key = result;
+  return true;
+}
 
-bool file_is_good(const std::string& filename) {
-  // filename.empty() 
-  std::ifstream file(filename);
-  return file.good();
+JoystickConfigRegistry::JoystickConfigRegistry() :
+  m_entries(),
+  m_by_filename(),
+  m_by_usb_id(),
+  m_mutex()
+{
+}
+
+JoystickConfigRegistry::JoystickConfigRegistry(const std::vector<JoystickConfig>& configs) :
+  m_entries(),
+  m_by_filename(),
+  m_by_usb_id(),
+  m_mutex()
+{
+  for (const auto& config : configs) {
+    add(config);
+  }
 }
 
-JoystickConfig get_config_for_usb_id(const std::string& usb_id) {
-  JoystickConfig ret;
-  for (const auto& config : joystick_configs) {
-    for (const auto& cur_usb_id : config.usb_ids) {
-      //std::cout << "  USB ID: " << cur_usb_id << "\n";
-      if (cur_usb_id == usb_id) {
-          m_verbose and std::cout << " FOUND usb_id: " << usb_id << "\n";
-          return config;
+JoystickConfigRegistry::JoystickConfigRegistry(const std::vector<JoystickConfigSource>& sources) :
+  m_entries(),
+  m_by_filename(),
+  m_by_usb_id(),
+  m_mutex()
+{
+  for (const auto& source : sources) {
+    add(source);
+  }
+}
+
+void JoystickConfigRegistry::add(const JoystickConfig& config) {
+  std::shared_ptr<Entry> entry = std::make_shared<Entry>();
+  entry->config = std::make_shared<JoystickConfig>(config);
+  add_entry(entry, config.usb_ids);
+}
+
+void JoystickConfigRegistry::add(const JoystickConfigSource& source) {
+  std::shared_ptr<Entry> entry = std::make_shared<Entry>();
+  entry->filename = source.filename;
+  entry->stamp = source.stamp;
+  m_by_filename.insert(std::make_pair(entry->filename, entry));
+  add_entry(entry, source.usb_ids);
+}
+
+void JoystickConfigRegistry::add_entry(std::shared_ptr<Entry> entry, const std::vector<std::string>& usb_ids) {
+  m_entries.push_back(entry);
+
+  for (const auto& usb_id : usb_ids) {
+    uint32_t key;
+    if (!pack_usb_id(usb_id, key)) {
+      std::cout << "ignoring malformed usb_id: " << usb_id << std::endl;
+    } else {
+      auto it = m_by_usb_id.insert(std::make_pair(key, entry)).first;
+      if (!it->second->sdl_mapping.empty()) {
+        it->second = entry; // .config files win over SDL mappings
       }
     }
   }
-  return ret;
 }
 
-JoystickConfig load_config(const std::string& filename) {
-  JoystickConfig config;
-  std::ifstream file(filename);
-  std::string line;
-
-  while (std::getline(file, line)) {
-    // Remove comments
-    size_t comment_pos = line.find('#');
-    if (comment_pos != std::string::npos) {
-      line = line.substr(0, comment_pos);
+void JoystickConfigRegistry::add_sdl_mapping(uint64_t sdl_guid, uint32_t usb_id, const std::string& mapping) {
+  std::shared_ptr<Entry> entry = std::make_shared<Entry>();
+  entry->sdl_mapping = mapping;
+  entry->sdl_guid = sdl_guid;
+  m_entries.push_back(entry);
+
+  m_by_sdl_guid.insert(std::make_pair(sdl_guid, entry));
+  m_by_usb_id.insert(std::make_pair(usb_id, entry));
+}
+
+std::shared_ptr<const JoystickConfig> JoystickConfigRegistry::load(Entry& entry) const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  if (!entry.config) {
+    if (!entry.sdl_mapping.empty()) {
+      std::shared_ptr<JoystickConfig> config = std::make_shared<JoystickConfig>();
+      if (!parse_sdl_mapping(entry.sdl_mapping, *config)) {
+        std::cout << "ignoring malformed SDL mapping: " << entry.sdl_mapping << std::endl;
+      }
+      entry.config = config;
+    } else {
+      m_verbose and std::cout << "loading config: " << entry.filename << std::endl;
+      entry.config = std::make_shared<JoystickConfig>(load_config(entry.filename));
     }
+  }
+  return entry.config;
+}
 
-    if (line.empty()) continue;
+std::shared_ptr<const JoystickConfig> JoystickConfigRegistry::find(uint32_t usb_id) const {
+  auto it = m_by_usb_id.find(usb_id);
+  if (it == m_by_usb_id.end()) {
+    return nullptr;
+  } else {
+    return load(*it->second);
+  }
+}
 
-    // Parse name=value
-    size_t equals_pos = line.find('=');
-    if (equals_pos == std::string::npos) continue;
+std::shared_ptr<const JoystickConfig> JoystickConfigRegistry::find(const std::string& usb_id) const {
+  uint32_t key;
+  if (!pack_usb_id(usb_id, key)) {
+    return nullptr;
+  } else {
+    return find(key);
+  }
+}
+
+std::shared_ptr<const JoystickConfig> JoystickConfigRegistry::find_device(uint32_t usb_id, uint64_t sdl_guid) const {
+  auto it = m_by_usb_id.find(usb_id);
+  if (it != m_by_usb_id.end() && it->second->sdl_mapping.empty()) {
+    return load(*it->second);
+  }
 
-    std::string name = line.substr(0, equals_pos);
-    std::string value = line.substr(equals_pos + 1);
+  auto guid_it = m_by_sdl_guid.find(sdl_guid);
+  if (guid_it != m_by_sdl_guid.end()) {
+    return load(*guid_it->second);
+  }
+
+  // SDL mapping for another version of the same device
+  if (it != m_by_usb_id.end()) {
+    return load(*it->second);
+  }
+
+  return nullptr;
+}
+
+size_t JoystickConfigRegistry::reuse_configs(const JoystickConfigRegistry& previous,
+                                             const std::vector<std::string>& changed) {
+  std::unordered_set<std::string> changed_files(changed.begin(), changed.end());
+  std::vector<std::shared_ptr<Entry> > reparse;
+  size_t count = 0;
+
+  {
+    // the configs are immutable, so the new entries can share them,
+    // the entries themselves stay separate as each registry guards
+    // its own with its mutex
+    std::lock_guard<std::mutex> previous_lock(previous.m_mutex);
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (const auto& it : m_entries) {
+      Entry& entry = *it;
+      if (entry.config) continue;
+
+      if (!entry.filename.empty() && changed_files.count(entry.filename)) {
+        reparse.push_back(it);
+        continue;
+      }
+
+      std::shared_ptr<Entry> old;
+      if (!entry.sdl_mapping.empty()) {
+        auto guid_it = previous.m_by_sdl_guid.find(entry.sdl_guid);
+        if (guid_it != previous.m_by_sdl_guid.end() && guid_it->second->sdl_mapping == entry.sdl_mapping) {
+          old = guid_it->second;
+        }
+      } else if (entry.stamp.known()) {
+        auto file_it = previous.m_by_filename.find(entry.filename);
+        if (file_it != previous.m_by_filename.end() && file_it->second->stamp == entry.stamp) {
+          old = file_it->second;
+        }
+      }
 
-    if (name == "icon_filename")
-    {
-      config.icon_filename = value;
-      config.icon_filename_is_good = file_is_good(Main::current()->get_data_directory() + value);
+      if (old && old->config) {
+        entry.config = old->config;
+        count += 1;
+      }
     }
+  }
+
+  // load() takes m_mutex itself
+  for (const auto& entry : reparse) {
+    load(*entry);
+  }
+  return count;
+}
+
+std::vector<std::shared_ptr<const JoystickConfig> > JoystickConfigRegistry::get_configs() const {
+  std::vector<std::shared_ptr<const JoystickConfig> > configs;
+  configs.reserve(m_entries.size());
+  for (const auto& entry : m_entries) {
+    configs.push_back(load(*entry));
+  }
+  return configs;
+}
+
+bool operator==(const JoystickConfig& lhs, const JoystickConfig& rhs) {
+  return (lhs.values == rhs.values &&
+          lhs.usb_ids == rhs.usb_ids &&
+          lhs.icon_filename == rhs.icon_filename &&
+          lhs.js_type == rhs.js_type &&
+          lhs.axes == rhs.axes &&
+          lhs.buttons == rhs.buttons &&
+          lhs.button_maxlen == rhs.button_maxlen &&
+          lhs.stick_axes == rhs.stick_axes &&
+          lhs.trigger_axes == rhs.trigger_axes);
+}
 
-    if (name == "js_type")
-    {
-      config.js_type = value;
+std::shared_ptr<const JoystickConfig> get_empty_config() {
+  static const std::shared_ptr<const JoystickConfig> empty_config = std::make_shared<JoystickConfig>();
+  return empty_config;
+}
+
+std::shared_ptr<const JoystickConfig> get_config_for_device(const std::string& usb_id, const std::string& sdl_guid) {
+  uint32_t key;
+  SdlGuid guid;
+  if (!pack_usb_id(usb_id, key) || !parse_sdl_guid(sdl_guid, guid)) {
+    return get_config_for_usb_id(usb_id);
+  }
+
+  std::shared_ptr<const JoystickConfig> config = get_joystick_configs()->find_device(key, guid.pack());
+  if (config) {
+    m_verbose and std::cout << " FOUND usb_id: " << usb_id << " sdl_guid: " << sdl_guid << "\n";
+    return config;
+  } else {
+    return get_empty_config();
+  }
+}
+
+std::shared_ptr<const JoystickConfig> get_config_for_usb_id(const std::string& usb_id) {
+  std::shared_ptr<const JoystickConfig> config = get_joystick_configs()->find(usb_id);
+  if (config) {
+    m_verbose and std::cout << " FOUND usb_id: " << usb_id << "\n";
+    return config;
+  } else {
+    return get_empty_config();
+  }
+}
+
+namespace {
+
+/** Read-only mapping of a whole file, empty when the file is empty or
+    can't be read */
+class MappedFile {
+private:
+  const char* m_data;
+  size_t m_size;
+
+public:
+  explicit MappedFile(const std::string& filename) : m_data(nullptr), m_size(0) {
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+      std::cout << filename << ": " << strerror(errno) << std::endl;
+      return;
     }
 
-    if (name == "usb_id")
-    {
-      m_verbose and std::cout << "   registering usb_id: " << value << std::endl;
-      config.usb_ids.push_back(value);
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+      void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (data == MAP_FAILED) {
+        std::cout << filename << ": " << strerror(errno) << std::endl;
+      } else {
+        m_data = static_cast<const char*>(data);
+        m_size = st.st_size;
+      }
     }
-    else
-    {
-      config.values[name] = value;
-
-      size_t underscore_pos = name.find('_');
-      if (name.rfind("axis_", 0) == 0)
-      {
-        config.axes.insert(config.axes.begin() + std::stoi(name.substr(underscore_pos + 1)), value);
+    close(fd);
+  }
+
+  ~MappedFile() {
+    if (m_data) munmap(const_cast<char*>(m_data), m_size);
+  }
+
+  const char* data() const { return m_data; }
+  size_t size() const { return m_size; }
+
+private:
+  MappedFile(const MappedFile&);
+  MappedFile& operator=(const MappedFile&);
+};
+
+// Slots beyond this are almost certainly a typo, don't allocate them
+const int max_config_slot = 1024;
+
+/** A piece of the mapped config file, C++11 has no std::string_view */
+struct Token {
+  const char* data;
+  size_t len;
+
+  bool starts_with(const char* prefix, size_t prefix_len) const {
+    return len >= prefix_len && memcmp(data, prefix, prefix_len) == 0;
+  }
+
+  bool equals(const char* str, size_t str_len) const {
+    return len == str_len && memcmp(data, str, str_len) == 0;
+  }
+
+  std::string str() const { return std::string(data, len); }
+};
+
+/** Parses the decimal slot number in "axis_N"/"button_N", returns -1
+    when it isn't one */
+int parse_slot(const char* ptr, const char* end) {
+  if (ptr == end) return -1;
+
+  int slot = 0;
+  for (; ptr != end; ++ptr) {
+    if (*ptr < '0' || *ptr > '9') return -1;
+    slot = slot * 10 + (*ptr - '0');
+    if (slot >= max_config_slot) return -1;
+  }
+  return slot;
+}
+
+struct SlotValue {
+  int slot;
+  Token value;
+  int line_number;
+};
+
+/** Prints "filename:line: message", or collects it in \a warnings */
+void warn(const std::string& filename, int line_number, const std::string& message,
+          std::vector<std::string>* warnings) {
+  std::ostringstream str;
+  str << filename << ":" << line_number << ": " << message;
+  if (warnings) {
+    warnings->push_back(str.str());
+  } else {
+    std::cout << str.str() << std::endl;
+  }
+}
+
+/** Writes \a slot_values into \a out, sized once to the highest slot,
+    later lines win over earlier ones for the same slot */
+void fill_slots(const std::vector<SlotValue>& slot_values, std::vector<Label>& out,
+                const char* prefix, const std::string& filename, std::vector<std::string>* warnings) {
+  int size = 0;
+  for (const auto& sv : slot_values) {
+    size = std::max(size, sv.slot + 1);
+  }
+
+  std::vector<int> set_by(size, 0);
+  out.assign(size, Label());
+  for (const auto& sv : slot_values) {
+    if (set_by[sv.slot]) {
+      std::ostringstream str;
+      str << prefix << sv.slot << " already set on line " << set_by[sv.slot] << ", using this one";
+      warn(filename, sv.line_number, str.str(), warnings);
+    }
+    set_by[sv.slot] = sv.line_number;
+    out[sv.slot] = Label(sv.value.data, sv.value.len);
+  }
+}
+
+JoystickConfig parse_config(const char* data, size_t len, const std::string& filename,
+                            std::vector<std::string>* warnings) {
+  JoystickConfig config;
+  std::vector<SlotValue> axes;
+  std::vector<SlotValue> buttons;
+
+  const char* end = data + len;
+  int line_number = 0;
+  for (const char* line = data; line < end; ) {
+    line_number += 1;
+
+    const char* eol = static_cast<const char*>(memchr(line, '\n', end - line));
+    if (!eol) eol = end;
+    const char* next = eol + 1;
+
+    // Remove comments and a DOS line ending
+    const char* comment = static_cast<const char*>(memchr(line, '#', eol - line));
+    if (comment) eol = comment;
+    if (eol > line && eol[-1] == '\r') --eol;
+
+    const char* equals = static_cast<const char*>(memchr(line, '=', eol - line));
+    if (!equals) {
+      bool blank = std::all_of(line, eol, [](char c) { return c == ' ' || c == '\t'; });
+      if (!blank) {
+        warn(filename, line_number, "ignoring line without '='", warnings);
       }
-      else if (name.rfind("button_", 0) == 0)
-      {
-        int new_pos = std::stoi(name.substr(underscore_pos + 1));
-        if (config.buttons.size() < new_pos) {
-            config.buttons.resize(new_pos);
-        }
-        config.buttons.insert(config.buttons.begin() + new_pos, value);
-        if (value.size() > config.button_maxlen) config.button_maxlen = value.size();
+      line = next;
+      continue;
+    }
+
+    // Parse name=value
+    Token name  = { line, static_cast<size_t>(equals - line) };
+    Token value = { equals + 1, static_cast<size_t>(eol - equals - 1) };
+    line = next;
+
+    if (name.equals("usb_id", 6)) {
+      m_verbose and std::cout << "   registering usb_id: " << value.str() << std::endl;
+      config.usb_ids.push_back(value.str());
+      continue;
+    }
+
+    if (name.equals("icon_filename", 13)) {
+      // checked lazily by IconCache when the icon is first displayed
+      config.icon_filename = value.str();
+    } else if (name.equals("js_type", 7)) {
+      config.js_type = value.str();
+    } else if (name.starts_with("axis_", 5) || name.starts_with("button_", 7)) {
+      bool is_axis = name.starts_with("axis_", 5);
+      int slot = parse_slot(name.data + (is_axis ? 5 : 7), name.data + name.len);
+      if (slot < 0) {
+        warn(filename, line_number, "ignoring bad slot number: " + name.str(), warnings);
+        continue;
+      }
+
+      if (is_axis) {
+        axes.push_back(SlotValue{slot, value, line_number});
+      } else {
+        buttons.push_back(SlotValue{slot, value, line_number});
+        if (static_cast<int>(value.len) > config.button_maxlen) config.button_maxlen = value.len;
       }
+    } else {
+      config.values[name.str()] = value.str();
     }
   }
 
+  fill_slots(axes, config.axes, "axis_", filename, warnings);
+  fill_slots(buttons, config.buttons, "button_", filename, warnings);
+
   return config;
 }
 
-std::vector<JoystickConfig> load_all_configs(const std::string& directory) {
-  m_verbose and std::cout << "loading config files in: " << directory  << std::endl;
+} // namespace
+
+JoystickConfig load_config(const std::string& filename, std::vector<std::string>* warnings) {
+  MappedFile file(filename);
+  if (!file.data()) return JoystickConfig();
+
+  return parse_config(file.data(), file.size(), filename, warnings);
+}
 
-  std::vector<JoystickConfig> conf_files;
+JoystickConfigSource scan_config(const std::string& filename) {
+  JoystickConfigSource source;
+  source.filename = filename;
+
+  MappedFile file(filename);
+  const char* end = file.data() + file.size();
+  for (const char* line = file.data(); line < end; ) {
+    const char* eol = static_cast<const char*>(memchr(line, '\n', end - line));
+    if (!eol) eol = end;
+
+    if (eol - line > 7 && memcmp(line, "usb_id=", 7) == 0) {
+      const char* value_end = static_cast<const char*>(memchr(line, '#', eol - line));
+      if (!value_end) value_end = eol;
+      if (value_end > line + 7 && value_end[-1] == '\r') --value_end;
+      source.usb_ids.push_back(std::string(line + 7, value_end));
+    }
+
+    line = eol + 1;
+  }
+
+  return source;
+}
+
+std::vector<std::string> get_config_search_path(const std::string& datadir) {
+  std::vector<std::string> path;
+
+  std::string dir = datadir;
+  while (dir.size() > 1 && dir[dir.size() - 1] == '/') dir.erase(dir.size() - 1);
+  path.push_back(dir);
+
+  // $XDG_DATA_DIRS lists the most important directory first
+  const char* xdg_data_dirs = getenv("XDG_DATA_DIRS");
+  std::string data_dirs = (xdg_data_dirs && *xdg_data_dirs) ? xdg_data_dirs : "/usr/local/share/:/usr/share/";
+  std::vector<std::string> data_path;
+  std::istringstream in(data_dirs);
+  std::string entry;
+  while (std::getline(in, entry, ':')) {
+    if (!entry.empty() && entry[0] == '/') {
+      if (entry[entry.size() - 1] != '/') entry += '/';
+      data_path.push_back(entry + "jstest-gtk");
+    }
+  }
+  path.insert(path.end(), data_path.rbegin(), data_path.rend());
+
+  const char* xdg_config_home = getenv("XDG_CONFIG_HOME");
+  const char* home = getenv("HOME");
+  if (xdg_config_home && xdg_config_home[0] == '/') {
+    path.push_back(std::string(xdg_config_home) + "/jstest-gtk");
+  } else if (home && home[0] == '/') {
+    path.push_back(std::string(home) + "/.config/jstest-gtk");
+  }
+
+  return path;
+}
+
+std::vector<std::string> get_config_filenames(const std::string& directory) {
+  std::vector<std::string> names;
   DIR* dir = opendir(directory.c_str());
-  if (!dir) return conf_files;
+  if (!dir) return names;
 
   struct dirent* entry;
   while ((entry = readdir(dir)) != nullptr) {
     std::string name = entry->d_name;
-    if (name.size() >= 7 && name.substr(name.size() - 7) == ".config") {
-      m_verbose and std::cout << "loading config: " << directory + "/" + name << std::endl;
-      conf_files.push_back(load_config(directory + "/" + name));
+    if (name.size() >= 7 && name.compare(name.size() - 7, 7, ".config") == 0) {
+      names.push_back(name);
     }
   }
-
   closedir(dir);
+
+  // readdir() order is arbitrary, sort so that the first config to
+  // claim a usb_id is the same on every run
+  std::sort(names.begin(), names.end());
+  return names;
+}
+
+bool is_known_js_type(const std::string& js_type) {
+  // the layouts JoystickTestWidget::setup_layout() knows
+  return (js_type == "ps4-dualshock4" ||
+          js_type == "ps3-sixaxis" ||
+          js_type == "ps2-dualshock2" ||
+          js_type == "xbox360");
+}
+
+std::vector<JoystickConfig> load_all_configs(const std::string& directory, int max_threads) {
+  m_verbose and std::cout << "loading config files in: " << directory  << std::endl;
+
+  std::vector<std::string> names = get_config_filenames(directory);
+
+  // parse in parallel, each result goes to the slot of its file, so
+  // the order doesn't depend on which thread finishes first
+  std::vector<JoystickConfig> conf_files(names.size());
+  parallel_for(names.size(), [&](size_t i) {
+      conf_files[i] = load_config(directory + "/" + names[i]);
+    }, max_threads);
+
   return conf_files;
 }
+
+#ifdef __TEST__
+
+// g++ -std=c++11 -O2 -c sdl_mapping.cpp parallel_for.cpp `pkg-config --cflags gtkmm-3.0`
+// g++ -std=c++11 -O2 -D__TEST__ joystick_config_files.cpp sdl_mapping.o parallel_for.o -o joystick-config-test -pthread `pkg-config --cflags gtkmm-3.0`
+
+#include <chrono>
+#include <random>
+#include <stdlib.h>
+
+bool m_verbose = false;
+
+int main(int argc, char** argv)
+{
+  typedef std::chrono::steady_clock Clock;
+
+  const int config_count = 10000;
+  const int lookup_count = 1000000;
+
+  std::vector<JoystickConfig> configs(config_count);
+  std::vector<std::string> usb_ids;
+  for (int i = 0; i < config_count; ++i) {
+    char usb_id[16];
+    snprintf(usb_id, sizeof(usb_id), "%04x:%04x", 0x1000 + i / 256, i % 256);
+    configs[i].usb_ids.push_back(usb_id);
+    configs[i].js_type = "xbox360";
+    for (int axis = 0; axis < 8; ++axis) configs[i].axes.push_back("axis");
+    for (int button = 0; button < 17; ++button) configs[i].buttons.push_back("button");
+    usb_ids.push_back(usb_id);
+  }
+
+  Clock::time_point start = Clock::now();
+  set_joystick_configs(std::make_shared<JoystickConfigRegistry>(configs));
+  double build_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+  std::mt19937 rng(0);
+  std::uniform_int_distribution<int> dist(0, config_count - 1);
+  std::vector<std::string> queries;
+  for (int i = 0; i < lookup_count; ++i) {
+    queries.push_back(usb_ids[dist(rng)]);
+  }
+
+  size_t found = 0;
+  start = Clock::now();
+  for (const auto& usb_id : queries) {
+    found += get_config_for_usb_id(usb_id)->axes.size();
+  }
+  double lookup_ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / lookup_count;
+
+  std::cout << "configs:          " << get_joystick_configs()->size() << "\n"
+            << "build registry:   " << build_ms << " ms\n"
+            << "lookup:           " << lookup_ns << " ns per get_config_for_usb_id()\n"
+            << "(found " << found << ")" << std::endl;
+
+  // parse benchmark: 1000 files of 50 lines each, axis and button
+  // lines shuffled so that slots arrive out of order
+  const int file_count = 1000;
+  char dir_template[] = "/tmp/jstest-gtk-config-parse-XXXXXX";
+  std::string tmpdir = mkdtemp(dir_template);
+
+  size_t line_count = 0;
+  for (int i = 0; i < file_count; ++i) {
+    std::vector<std::string> lines;
+    for (int axis = 0; axis < 16; ++axis) lines.push_back("axis_" + std::to_string(axis) + "=Axis " + std::to_string(axis));
+    for (int button = 0; button < 30; ++button) lines.push_back("button_" + std::to_string(button) + "=Button " + std::to_string(button));
+    std::shuffle(lines.begin(), lines.end(), rng);
+
+    char name[64];
+    snprintf(name, sizeof(name), "/controller-%04d.config", i);
+    std::ofstream out(tmpdir + name);
+    out << "# generated\nusb_id=" << usb_ids[i] << "\njs_type=xbox360\nicon_filename=xbox360.png\n";
+    for (const auto& line : lines) out << line << "\n";
+    line_count += lines.size() + 4;
+  }
+
+  start = Clock::now();
+  std::vector<JoystickConfig> parsed = load_all_configs(tmpdir, 1);
+  double parse_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+  start = Clock::now();
+  std::vector<JoystickConfig> parallel = load_all_configs(tmpdir);
+  double parallel_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+  bool merge_ok = parallel == parsed;
+
+  bool slots_ok = parsed.size() == file_count;
+  for (const auto& config : parsed) {
+    slots_ok = slots_ok && config.axes.size() == 16 && config.buttons.size() == 30;
+    for (size_t axis = 0; slots_ok && axis < config.axes.size(); ++axis) {
+      slots_ok = config.axes[axis] == "Axis " + std::to_string(axis);
+    }
+    for (size_t button = 0; slots_ok && button < config.buttons.size(); ++button) {
+      slots_ok = config.buttons[button] == "Button " + std::to_string(button);
+    }
+  }
+
+  // 32 open pads of the same model share a single config, and the
+  // labels of different models share their strings
+  std::shared_ptr<const JoystickConfig> first = get_config_for_usb_id(usb_ids[0]);
+  bool shared_ok = true;
+  for (int i = 0; i < 32; ++i) {
+    shared_ok = shared_ok && get_config_for_usb_id(usb_ids[0]) == first;
+  }
+  shared_ok = shared_ok && &parsed[0].axes[3].str() == &parsed[1].axes[3].str();
+
+  std::cout << "parse:            " << line_count << " lines in " << file_count << " files, "
+            << parse_ms << " ms (" << parse_ms * 1e6 / line_count << " ns per line)\n"
+            << "parallel parse:   " << parallel_ms << " ms on " << get_io_thread_count() << " threads, "
+            << "same order: " << (merge_ok ? "yes" : "NO") << "\n"
+            << "slots in order:   " << (slots_ok ? "yes" : "NO") << "\n"
+            << "configs shared:   " << (shared_ok ? "yes" : "NO") << std::endl;
+
+  std::string cmd = "rm -rf '" + tmpdir + "'";
+  return system(cmd.c_str()) == 0 && slots_ok && shared_ok && merge_ok ? 0 : 1;
+}
+#endif
+
+/* EOF */
@@ -23,7 +23,10 @@
 
 #include <iostream>
 #include <fstream>
+#include <memory>
+#include <mutex>
 #include <sstream>
+#include <stdint.h>
 #include <unordered_map>
 
 #include <vector>
@@ -34,24 +37,182 @@
 
 // namespace fs = std::filesystem;
 
+/** A string that is stored once in a process wide pool. Labels like
+    "A" or "Left X" repeat across nearly every config, so configs only
+    hold a pointer to them and comparing two labels is a pointer
+    comparison. Pooled strings are never freed. */
+class Label {
+private:
+  const std::string* m_str;
+
+public:
+  Label();
+  Label(const char* str);
+  Label(const std::string& str);
+  Label(const char* data, size_t len);
+
+  const std::string& str() const { return *m_str; }
+  operator const std::string&() const { return *m_str; }
+  bool empty() const { return m_str->empty(); }
+  size_t size() const { return m_str->size(); }
+
+  bool operator==(const Label& rhs) const { return m_str == rhs.m_str; }
+  bool operator!=(const Label& rhs) const { return m_str != rhs.m_str; }
+  bool operator==(const std::string& rhs) const { return *m_str == rhs; }
+  bool operator==(const char* rhs) const { return *m_str == rhs; }
+};
+
+inline std::ostream& operator<<(std::ostream& out, const Label& label) { return out << label.str(); }
+
+/** Configs are shared between all devices of a model and never
+    modified once they are in the registry, see get_config_for_device() */
 struct JoystickConfig {
+    // keys that don't have a field of their own
     std::unordered_map<std::string, std::string> values;
     std::vector<std::string> usb_ids;
     std::string icon_filename;
     std::string js_type;
-    bool icon_filename_is_good = false;
-    std::vector<std::string> axes;
-    std::vector<std::string> buttons;
+    std::vector<Label> axes;
+    std::vector<Label> buttons;
     int button_maxlen = 0;
+    // stick layout when there is no js_type: x/y axis pairs and triggers
+    std::vector<unsigned int> stick_axes;
+    std::vector<unsigned int> trigger_axes;
 };
 
 
-JoystickConfig load_config(const std::string& filename);
-JoystickConfig get_config_for_usb_id(const std::string& usb_id);
+/** Packs a "vvvv:pppp" usb_id into (vendor << 16 | product), returns
+    false when \a usb_id isn't of that form */
+bool pack_usb_id(const std::string& usb_id, uint32_t& key);
+
+/** mtime and size of a config file, all 0 when unknown */
+struct ConfigFileStamp {
+    int64_t mtime_sec = 0;
+    int64_t mtime_nsec = 0;
+    int64_t size = 0;
+
+    bool known() const { return mtime_sec != 0 || mtime_nsec != 0 || size != 0; }
+    bool operator==(const ConfigFileStamp& rhs) const {
+      return mtime_sec == rhs.mtime_sec && mtime_nsec == rhs.mtime_nsec && size == rhs.size;
+    }
+};
+
+/** A config file that hasn't been parsed yet, only its usb_ids are
+    known, which is all the registry needs to index it */
+struct JoystickConfigSource {
+    std::string filename;
+    std::vector<std::string> usb_ids;
+    ConfigFileStamp stamp;
+};
+
+/** All known JoystickConfigs, indexed by packed usb_id. Configs added
+    as a JoystickConfigSource are parsed on first lookup. */
+class JoystickConfigRegistry
+{
+private:
+  struct Entry {
+    std::string filename;
+    ConfigFileStamp stamp;
+    std::string sdl_mapping; // set for configs from a gamecontrollerdb.txt
+    uint64_t sdl_guid = 0;
+    std::shared_ptr<const JoystickConfig> config; // nullptr until parsed
+  };
+
+  std::vector<std::shared_ptr<Entry> > m_entries;
+  std::unordered_map<std::string, std::shared_ptr<Entry> > m_by_filename;
+  std::unordered_map<uint32_t, std::shared_ptr<Entry> > m_by_usb_id;
+  std::unordered_map<uint64_t, std::shared_ptr<Entry> > m_by_sdl_guid; // SdlGuid::pack()
+  mutable std::mutex m_mutex; // guards Entry::config
+
+public:
+  JoystickConfigRegistry();
+  explicit JoystickConfigRegistry(const std::vector<JoystickConfig>& configs);
+  explicit JoystickConfigRegistry(const std::vector<JoystickConfigSource>& sources);
+
+  /** When several configs claim the same usb_id the one added first wins */
+  void add(const JoystickConfig& config);
+  void add(const JoystickConfigSource& source);
+
+  /** Adds an SDL mapping string, indexed by its GUID and usb_id. A
+      .config claiming the same usb_id wins over SDL mappings, no
+      matter in which order they were added. */
+  void add_sdl_mapping(uint64_t sdl_guid, uint32_t usb_id, const std::string& mapping);
+
+  /** Returns nullptr when no config claims \a usb_id */
+  std::shared_ptr<const JoystickConfig> find(uint32_t usb_id) const;
+  std::shared_ptr<const JoystickConfig> find(const std::string& usb_id) const;
+
+  /** Like find(), but prefers the SDL mapping for the exact device
+      version when there is no .config for \a usb_id */
+  std::shared_ptr<const JoystickConfig> find_device(uint32_t usb_id, uint64_t sdl_guid) const;
+
+  /** Takes over the configs \a previous already parsed for files
+      whose stamp didn't change and for unchanged SDL mappings, so a
+      reload doesn't parse them again and devices of an unchanged model
+      keep sharing one config instance with the registry. The files in
+      \a changed are parsed again right away, before the registry is
+      handed out. Returns the number of configs taken over. */
+  size_t reuse_configs(const JoystickConfigRegistry& previous,
+                       const std::vector<std::string>& changed = std::vector<std::string>());
+
+  /** All configs, parses the ones that weren't used yet */
+  std::vector<std::shared_ptr<const JoystickConfig> > get_configs() const;
+  size_t size() const { return m_entries.size(); }
+
+private:
+  void add_entry(std::shared_ptr<Entry> entry, const std::vector<std::string>& usb_ids);
+  std::shared_ptr<const JoystickConfig> load(Entry& entry) const;
+
+  JoystickConfigRegistry(const JoystickConfigRegistry&);
+  JoystickConfigRegistry& operator=(const JoystickConfigRegistry&);
+};
+
+/** Parses \a filename, problems are printed, or collected in
+    \a warnings when given */
+JoystickConfig load_config(const std::string& filename, std::vector<std::string>* warnings = nullptr);
+
+/** Only reads the usb_id lines of \a filename */
+JoystickConfigSource scan_config(const std::string& filename);
+
+/** Directories config files are looked up in, lowest priority first:
+    \a datadir, $XDG_DATA_DIRS/jstest-gtk/ and the user's
+    $XDG_CONFIG_HOME/jstest-gtk/. A file in a later directory replaces
+    a file of the same name in an earlier one and wins usb_id
+    conflicts. */
+std::vector<std::string> get_config_search_path(const std::string& datadir);
+
+bool operator==(const JoystickConfig& lhs, const JoystickConfig& rhs);
+inline bool operator!=(const JoystickConfig& lhs, const JoystickConfig& rhs) { return !(lhs == rhs); }
+
+/** Returns the config for \a usb_id, or an empty config when there is
+    none, never nullptr. The config stays alive when the registry gets
+    replaced by a reload. */
+std::shared_ptr<const JoystickConfig> get_config_for_usb_id(const std::string& usb_id);
+
+/** The config of devices no config claims */
+std::shared_ptr<const JoystickConfig> get_empty_config();
+
+/** Same as get_config_for_usb_id(), but also matches SDL mappings by
+    the device's SDL GUID, see Joystick::get_sdl_guid() */
+std::shared_ptr<const JoystickConfig> get_config_for_device(const std::string& usb_id, const std::string& sdl_guid);
 
-std::vector<JoystickConfig> load_all_configs(const std::string& directory);
+/** The *.config files in \a directory, sorted, without the directory */
+std::vector<std::string> get_config_filenames(const std::string& directory);
+
+/** True when JoystickTestWidget has a layout for \a js_type */
+bool is_known_js_type(const std::string& js_type);
+
+/** Parses all *.config files in \a directory on up to \a max_threads
+    threads, 0 picks a default, the result is sorted by filename */
+std::vector<JoystickConfig> load_all_configs(const std::string& directory, int max_threads = 0);
 
-extern std::vector<JoystickConfig> joystick_configs;
+/** The registry in use, safe to call from the probe worker threads
+    while the main loop swaps in a reloaded one */
+std::shared_ptr<const JoystickConfigRegistry> get_joystick_configs();
+
+/** Atomically replaces the registry, lookups that are in progress
+    keep using the old one */
+void set_joystick_configs(std::shared_ptr<const JoystickConfigRegistry> configs);
 
 
 
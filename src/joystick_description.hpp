@@ -31,9 +31,22 @@ public:
   std::string vendor_id;
   std::string product_id;
   std::string usb_id;
+  std::string syspath;
   int axis_count;
   int button_count;
 
+  JoystickDescription()
+    : filename(),
+      name(),
+      js_id(),
+      vendor_id(),
+      product_id(),
+      usb_id(),
+      syspath(),
+      axis_count(0),
+      button_count(0)
+  {}
+
   JoystickDescription(const std::string& filename_,
                       const std::string& name_,
                       const std::string& js_id_,
@@ -41,13 +54,15 @@ public:
                       const std::string& product_id_,
                       const std::string& usb_id_,
                       int axis_count_,
-                      int button_count_)
+                      int button_count_,
+                      const std::string& syspath_ = std::string())
     : filename(filename_),
       name(name_),
       js_id(js_id_),
       vendor_id(vendor_id_),
       product_id(product_id_),
       usb_id(usb_id_),
+      syspath(syspath_),
       axis_count(axis_count_),
       button_count(button_count_)
   {}
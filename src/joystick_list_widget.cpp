@@ -20,6 +20,7 @@
 #include <gtkmm.h>
 
 #include "main.hpp"
+#include "icon_cache.hpp"
 #include "joystick.hpp"
 #include "joystick_description.hpp"
 #include "joystick_list_widget.hpp"
@@ -54,6 +55,9 @@ private:
 
 DeviceListColumns* DeviceListColumns::instance_ = 0;
 
+// Icons in the list are scaled down to fit into this many pixels
+static const int list_icon_size = 80;
+
 JoystickListWidget::JoystickListWidget() :
   Gtk::Window(),
   m_vbox(),
@@ -64,7 +68,7 @@ JoystickListWidget::JoystickListWidget() :
 
 {
   set_title("Joystick Preferences");
-  set_icon_from_file(Main::current()->get_data_directory() + "generic.png");
+  set_icon(IconCache::instance().get(Main::current()->get_data_directory() + "generic.png"));
   set_default_size(450, 310);
   //set_border_width(5);
 
@@ -90,19 +94,31 @@ JoystickListWidget::JoystickListWidget() :
   treeview.append_column("Icon", DeviceListColumns::instance().icon);
   treeview.append_column("Name", DeviceListColumns::instance().name);
 
+  // Keep the rows sorted by device, no matter in which order the
+  // probes complete (js2 < js10)
+  device_list->set_sort_func(DeviceListColumns::instance().path,
+                             [](const Gtk::TreeModel::iterator& lhs, const Gtk::TreeModel::iterator& rhs) -> int {
+                               return compare_device_files((*lhs)[DeviceListColumns::instance().path],
+                                                           (*rhs)[DeviceListColumns::instance().path]);
+                             });
+  device_list->set_sort_column(DeviceListColumns::instance().path, Gtk::SORT_ASCENDING);
+
   // Signals
   treeview.signal_row_activated().connect(sigc::mem_fun(this, &JoystickListWidget::on_row_activated));
   m_refresh_button.signal_clicked().connect([this]{ on_refresh_button(); });
   m_properties_button.signal_clicked().connect([this]{ on_properties_button(); });
   m_close_button.signal_clicked().connect([this]{ hide(); });
 
+  prober.signal_probed.connect(sigc::mem_fun(this, &JoystickListWidget::on_joystick_probed));
+  prober.signal_failed.connect(sigc::mem_fun(this, &JoystickListWidget::on_joystick_probe_failed));
+
   m_close_button.grab_focus();
   
-  udev_monitor.reset(new UdevMonitor());
-  udev_monitor->signal_joystick_event.connect([this](const std::string& action, const std::string& devnode) {
-    m_verbose and std::cout << "Joystick " << action << ": " << devnode << std::endl;
-    on_refresh_button();
-  });
+  if (UdevMonitor* udev_monitor = Main::current()->get_udev_monitor())
+  {
+    udev_monitor->signal_joystick_event.connect(sigc::mem_fun(this, &JoystickListWidget::on_udev_js_event));
+    udev_monitor->signal_uevent.connect(sigc::mem_fun(this, &JoystickListWidget::on_uevent));
+  }
 
   on_refresh_button();
 }
@@ -120,41 +136,120 @@ JoystickListWidget::on_row_activated(const Gtk::TreeModel::Path& path, Gtk::Tree
 void
 JoystickListWidget::on_refresh_button()
 {
-  const std::vector<JoystickDescription>& joysticks = Joystick::get_joysticks();
-
+  prober.cancel();
   device_list->clear();
+  registry.clear();
 
-  for(std::vector<JoystickDescription>::const_iterator i = joysticks.begin(); i != joysticks.end(); ++i)
+  // Rows get added in on_joystick_probed() as the probes complete
+  for(const auto& filename : Joystick::get_joystick_filenames())
   {
-    Gtk::ListStore::iterator it = device_list->append();
-
-    const Glib::ustring& name = i->name;
-    Glib::ustring icon_filename;
-    JoystickConfig js_cfg = get_config_for_usb_id(i->usb_id);
-    
-    icon_filename = js_cfg.icon_filename;
-    
-    if (! js_cfg.icon_filename_is_good) icon_filename = "generic.png"; // NOTE: you can set the icon_filename in a config file for the controller
-
-    (*it)[DeviceListColumns::instance().icon] = Gdk::Pixbuf::create_from_file(Main::current()->get_data_directory() + icon_filename);
-    (*it)[DeviceListColumns::instance().path] = i->filename;
-
-    std::ostringstream out;
-    out << name << "\n"
-        << "Device: " << i->filename << "\n"
-        // << "js_id: " << i->js_id << "\n"
-        // << "vendor_id: " << i->vendor_id << "\n"
-        // << "product_id: " << i->product_id << "\n"
-        << "usb_id: " << i->usb_id << "\n"
-        << "Axes: " << i->axis_count << "\n"
-        << "Buttons: " << i->button_count;
-    (*it)[DeviceListColumns::instance().name] = out.str();
+    prober.probe(filename, get_js_dev_id_from_filename(filename));
   }
+}
 
-  if (!joysticks.empty())
+void
+JoystickListWidget::on_joystick_probed(const JoystickDescription& joystick)
+{
+  registry.update(joystick,
+                  [this](const Gtk::TreeRowReference& row) { erase_row(row); },
+                  [this](const JoystickDescription& description, const Registry::Device* sibling) {
+                    return create_row(description, sibling);
+                  });
+
+  if (!treeview.get_selection()->get_selected())
     treeview.get_selection()->select(device_list->children().begin());
 }
 
+Gtk::TreeRowReference
+JoystickListWidget::create_row(const JoystickDescription& joystick, const Registry::Device* sibling)
+{
+  Gtk::ListStore::iterator it = device_list->append();
+
+  // the icon only depends on the model, take it from another device of
+  // the same model if there is one
+  Glib::RefPtr<Gdk::Pixbuf> icon;
+  if (sibling && sibling->row.is_valid())
+  {
+    icon = device_list->get_iter(sibling->row.get_path())->get_value(DeviceListColumns::instance().icon);
+  }
+  else
+  {
+    std::shared_ptr<const JoystickConfig> js_cfg = get_config_for_usb_id(joystick.usb_id);
+
+    // NOTE: you can set the icon_filename in a config file for the controller
+    if (!js_cfg->icon_filename.empty())
+      icon = IconCache::instance().get(Main::current()->get_data_directory() + js_cfg->icon_filename, list_icon_size);
+    if (!icon)
+      icon = IconCache::instance().get(Main::current()->get_data_directory() + "generic.png", list_icon_size);
+  }
+
+  (*it)[DeviceListColumns::instance().icon] = icon;
+  (*it)[DeviceListColumns::instance().path] = joystick.filename;
+
+  std::ostringstream out;
+  out << joystick.name << "\n"
+      << "Device: " << joystick.filename << "\n"
+      // << "js_id: " << joystick.js_id << "\n"
+      // << "vendor_id: " << joystick.vendor_id << "\n"
+      // << "product_id: " << joystick.product_id << "\n"
+      << "usb_id: " << joystick.usb_id << "\n"
+      << "Axes: " << joystick.axis_count << "\n"
+      << "Buttons: " << joystick.button_count;
+  (*it)[DeviceListColumns::instance().name] = out.str();
+
+  return Gtk::TreeRowReference(device_list, device_list->get_path(it));
+}
+
+void
+JoystickListWidget::erase_row(const Gtk::TreeRowReference& row)
+{
+  if (row.is_valid())
+  {
+    device_list->erase(device_list->get_iter(row.get_path()));
+  }
+}
+
+void
+JoystickListWidget::on_joystick_probe_failed(const std::string& filename, const std::string& error)
+{
+  std::cout << filename << ": " << error << std::endl;
+}
+
+void
+JoystickListWidget::on_udev_js_event(const std::string& action, const std::string& devnode, const std::string& stable_id)
+{
+  m_verbose and std::cout << "Joystick " << action << ": " << devnode << std::endl;
+
+  // Only touch the device that changed instead of rescanning all of them
+  if (action == "remove")
+  {
+    remove_device(devnode);
+  }
+  else if (action == "add")
+  {
+    prober.probe(devnode, get_js_dev_id_from_filename(devnode));
+  }
+}
+
+void
+JoystickListWidget::on_uevent(const std::string& action, const std::string& syspath, unsigned long long seqnum)
+{
+  // name or capabilities may have changed, refresh the row
+  if (action == "change")
+  {
+    if (const Registry::Device* device = registry.find_by_syspath(syspath))
+    {
+      prober.probe(device->description.filename, device->description.js_id);
+    }
+  }
+}
+
+void
+JoystickListWidget::remove_device(const std::string& filename)
+{
+  registry.remove(filename, [this](const Gtk::TreeRowReference& row) { erase_row(row); });
+}
+
 void
 JoystickListWidget::on_properties_button()
 {
@@ -28,6 +28,8 @@
 #include <gtkmm/liststore.h>
 #include <gtkmm/window.h>
 
+#include "device_registry.hpp"
+#include "joystick_prober.hpp"
 #include "udev_monitor.hpp"
 
 class JoystickListWidget : public Gtk::Window
@@ -43,9 +45,12 @@ private:
   Gtk::Button m_properties_button;
   Gtk::Button m_close_button;
 
+  typedef DeviceRegistry<Gtk::TreeRowReference> Registry;
+
   Glib::RefPtr<Gtk::ListStore> device_list;
+  Registry registry;
+  JoystickProber prober;
   
-  std::unique_ptr<UdevMonitor> udev_monitor;
 
 public:
   JoystickListWidget();
@@ -55,6 +60,16 @@ public:
   void on_row_activated(const Gtk::TreeModel::Path& path, Gtk::TreeViewColumn* column);
   
 private:
+  void on_joystick_probed(const JoystickDescription& joystick);
+  void on_joystick_probe_failed(const std::string& filename, const std::string& error);
+  void on_udev_js_event(const std::string& action, const std::string& devnode, const std::string& stable_id);
+  void on_uevent(const std::string& action, const std::string& syspath, unsigned long long seqnum);
+  void remove_device(const std::string& filename);
+
+  Gtk::TreeRowReference create_row(const JoystickDescription& joystick, const Registry::Device* sibling);
+  void erase_row(const Gtk::TreeRowReference& row);
+
+
   JoystickListWidget(const JoystickListWidget&);
   JoystickListWidget& operator=(const JoystickListWidget&);
 };
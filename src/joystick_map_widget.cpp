@@ -26,7 +26,7 @@ JoystickMapWidget::JoystickMapWidget(Joystick& joystick)
   : Gtk::Dialog("Mapping: " + joystick.get_name()),
     label("Change the order of axis and button. The order applies directly to the "
           "joystick kernel driver, so it will work in any game, it is however not "
-          "persistant across reboots."),
+          "persistant across reboots unless saved with \"Save Profile\"."),
     axis_map(joystick, RemapWidget::REMAP_AXIS),
     button_map(joystick, RemapWidget::REMAP_BUTTON)
 {
@@ -0,0 +1,264 @@
+/*
+**  jstest-gtk - A graphical joystick tester
+**  Copyright (C) 2025 Raphael Rosch <jstest-bugs@insaner.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <condition_variable>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <glibmm/main.h>
+
+#include "joystick.hpp"
+#include "joystick_prober.hpp"
+#include "main.hpp"
+
+struct JoystickProber::Queue
+{
+  struct Job {
+    unsigned int id;
+    std::string filename;
+    std::string js_id;
+  };
+
+  struct Result {
+    unsigned int id;
+    bool ok;
+    JoystickDescription description;
+    std::string error;
+  };
+
+  std::mutex mutex;
+  std::condition_variable cond;
+  std::deque<Job> jobs;
+  std::deque<Job> started;
+  std::deque<Result> results;
+
+  // Set to nullptr when the JoystickProber goes away, workers that
+  // are stuck in a probe may outlive it
+  Glib::Dispatcher* dispatcher;
+  bool quit;
+
+  int max_workers;
+  int workers;
+  int idle_workers;
+
+  Queue(Glib::Dispatcher* dispatcher_, int max_workers_) :
+    mutex(),
+    cond(),
+    jobs(),
+    started(),
+    results(),
+    dispatcher(dispatcher_),
+    quit(false),
+    max_workers(max_workers_),
+    workers(0),
+    idle_workers(0)
+  {}
+};
+
+JoystickProber::JoystickProber(int max_workers, int timeout_ms) :
+  m_queue(),
+  m_dispatcher(),
+  m_timeout_ms(timeout_ms),
+  m_next_id(0),
+  m_pending(),
+  m_timed_out()
+{
+  m_queue = std::make_shared<Queue>(&m_dispatcher, max_workers);
+  m_dispatcher.connect(sigc::mem_fun(this, &JoystickProber::on_dispatch));
+}
+
+JoystickProber::~JoystickProber()
+{
+  cancel();
+
+  std::lock_guard<std::mutex> lock(m_queue->mutex);
+  m_queue->dispatcher = nullptr;
+  m_queue->quit = true;
+  m_queue->cond.notify_all();
+}
+
+void
+JoystickProber::probe(const std::string& filename, const std::string& js_id)
+{
+  unsigned int id = ++m_next_id;
+
+  // the timeout is armed once a worker picks the job up, time spent
+  // waiting behind other devices doesn't count
+  m_pending[id] = sigc::connection();
+
+  std::lock_guard<std::mutex> lock(m_queue->mutex);
+  m_queue->jobs.push_back(Queue::Job{id, filename, js_id});
+
+  if (m_queue->idle_workers == 0 && m_queue->workers < m_queue->max_workers)
+  {
+    m_queue->workers += 1;
+    std::thread(&JoystickProber::run_worker, m_queue).detach();
+  }
+  else
+  {
+    m_queue->cond.notify_one();
+  }
+}
+
+void
+JoystickProber::cancel()
+{
+  for(auto& it : m_pending)
+  {
+    it.second.disconnect();
+  }
+  m_pending.clear();
+
+  std::lock_guard<std::mutex> lock(m_queue->mutex);
+  m_queue->jobs.clear();
+}
+
+void
+JoystickProber::on_dispatch()
+{
+  std::deque<Queue::Job> started;
+  std::deque<Queue::Result> results;
+  {
+    std::lock_guard<std::mutex> lock(m_queue->mutex);
+    started.swap(m_queue->started);
+    results.swap(m_queue->results);
+  }
+
+  for(auto& job : started)
+  {
+    auto it = m_pending.find(job.id);
+    if (it != m_pending.end())
+    {
+      it->second = Glib::signal_timeout().connect(
+        sigc::bind(sigc::mem_fun(this, &JoystickProber::on_timeout), job.id, job.filename),
+        m_timeout_ms);
+    }
+  }
+
+  for(auto& result : results)
+  {
+    if (m_timed_out.erase(result.id))
+    {
+      // the worker that got stuck on this device is back, so the
+      // extra worker started in on_timeout() is no longer needed
+      std::lock_guard<std::mutex> lock(m_queue->mutex);
+      m_queue->max_workers -= 1;
+      continue;
+    }
+
+    auto it = m_pending.find(result.id);
+    if (it == m_pending.end())
+    {
+      continue; // cancelled
+    }
+
+    it->second.disconnect();
+    m_pending.erase(it);
+
+    if (result.ok)
+    {
+      signal_probed(result.description);
+    }
+    else
+    {
+      signal_failed(result.description.filename, result.error);
+    }
+  }
+}
+
+bool
+JoystickProber::on_timeout(unsigned int id, const std::string& filename)
+{
+  m_verbose and std::cout << filename << ": probe timed out" << std::endl;
+
+  m_pending.erase(id);
+
+  {
+    // a worker is blocked on this device, allow one more so the
+    // remaining devices still get probed
+    std::lock_guard<std::mutex> lock(m_queue->mutex);
+    m_timed_out.insert(id);
+    m_queue->max_workers += 1;
+    if (!m_queue->jobs.empty() && m_queue->idle_workers == 0)
+    {
+      m_queue->workers += 1;
+      std::thread(&JoystickProber::run_worker, m_queue).detach();
+    }
+  }
+
+  signal_failed(filename, "timed out");
+
+  return false;
+}
+
+void
+JoystickProber::run_worker(std::shared_ptr<Queue> queue)
+{
+  std::unique_lock<std::mutex> lock(queue->mutex);
+
+  while (true)
+  {
+    queue->idle_workers += 1;
+    queue->cond.wait(lock, [&queue]{ return queue->quit || !queue->jobs.empty(); });
+    queue->idle_workers -= 1;
+
+    if (queue->quit)
+    {
+      break;
+    }
+
+    Queue::Job job = queue->jobs.front();
+    queue->jobs.pop_front();
+
+    queue->started.push_back(job);
+    if (queue->dispatcher)
+    {
+      queue->dispatcher->emit();
+    }
+
+    lock.unlock();
+
+    Queue::Result result;
+    result.id = job.id;
+    result.description.filename = job.filename;
+    try
+    {
+      result.description = Joystick::probe(job.filename, job.js_id);
+      result.ok = true;
+    }
+    catch(std::exception& err)
+    {
+      result.ok = false;
+      result.error = err.what();
+    }
+
+    lock.lock();
+
+    queue->results.push_back(result);
+    if (queue->dispatcher)
+    {
+      queue->dispatcher->emit();
+    }
+  }
+
+  queue->workers -= 1;
+}
+
+/* EOF */
@@ -0,0 +1,79 @@
+/*
+**  jstest-gtk - A graphical joystick tester
+**  Copyright (C) 2025 Raphael Rosch <jstest-bugs@insaner.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HEADER_JSTEST_GTK_JOYSTICK_PROBER_HPP
+#define HEADER_JSTEST_GTK_JOYSTICK_PROBER_HPP
+
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <glibmm/dispatcher.h>
+#include <sigc++/signal.h>
+#include <sigc++/connection.h>
+
+#include "joystick_description.hpp"
+
+/** Runs Joystick::probe() on a small pool of worker threads, so that
+    a slow or half-dead device can't stall the GTK main loop. Results
+    are delivered in the main loop, one signal per device, as soon as
+    each probe completes. */
+class JoystickProber
+{
+private:
+  struct Queue;
+
+  std::shared_ptr<Queue> m_queue;
+  Glib::Dispatcher m_dispatcher;
+  int m_timeout_ms;
+
+  unsigned int m_next_id;
+  std::map<unsigned int, sigc::connection> m_pending;
+  std::set<unsigned int> m_timed_out;
+
+public:
+  JoystickProber(int max_workers = 4, int timeout_ms = 2000);
+  ~JoystickProber();
+
+  /** Queue a device for probing */
+  void probe(const std::string& filename, const std::string& js_id);
+
+  /** Drop all queued probes and ignore the results of the ones still
+      running */
+  void cancel();
+
+  sigc::signal<void, const JoystickDescription&> signal_probed;
+
+  /** Emitted with the filename and an error message when a probe
+      fails or doesn't complete within the timeout, counted from when
+      a worker starts on it */
+  sigc::signal<void, const std::string&, const std::string&> signal_failed;
+
+private:
+  void on_dispatch();
+  bool on_timeout(unsigned int id, const std::string& filename);
+
+  static void run_worker(std::shared_ptr<Queue> queue);
+
+  JoystickProber(const JoystickProber&);
+  JoystickProber& operator=(const JoystickProber&);
+};
+
+#endif
+
+/* EOF */
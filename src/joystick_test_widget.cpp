@@ -17,6 +17,7 @@
 **  along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <algorithm>
 #include <sstream>
 #include <iostream>
 #include <gtkmm/label.h>
@@ -25,6 +26,7 @@
 #include <gtkmm/image.h>
 
 #include "main.hpp"
+#include "icon_cache.hpp"
 #include "joystick.hpp"
 #include "button_widget.hpp"
 #include "joystick_map_widget.hpp"
@@ -46,6 +48,8 @@ JoystickTestWidget::JoystickTestWidget(JoystickGui& gui, Joystick& joystick_, bo
   button_frame("Buttons"),
   mapping_button("Mapping"),
   calibration_button("Calibration"),
+  capture_button("Capture"),
+  profile_button("Save Profile"),
   close_button(Gtk::Stock::CLOSE),
   buttonbox(),
   stick1_widget(128, 128),
@@ -54,10 +58,18 @@ JoystickTestWidget::JoystickTestWidget(JoystickGui& gui, Joystick& joystick_, bo
   rudder_widget(128, 32),
   throttle_widget(32, 128),
   left_trigger_widget(32, 128, true),
-  right_trigger_widget(32, 128, true)
+  right_trigger_widget(32, 128, true),
+  travel_check("Analyze trigger travel"),
+  travel_widgets(),
+  travel_pending(),
+  travel_timeout(),
+  travel_overlay(),
+  drift_monitor(joystick.get_axis_count()),
+  button_chatter(joystick.get_button_count()),
+  trigger_travel(joystick.get_axis_count())
 {
   set_title(joystick_.get_name());
-  set_icon_from_file(Main::current()->get_data_directory() + "generic.png");
+  set_icon(IconCache::instance().get(Main::current()->get_data_directory() + "generic.png"));
   label_base = label.get_label();
   label.set_use_markup(true);
   label.set_selectable(true);
@@ -73,36 +85,34 @@ JoystickTestWidget::JoystickTestWidget(JoystickGui& gui, Joystick& joystick_, bo
   connected = true;
   for(int i = 0; i < joystick.get_axis_count(); ++i)
   {
-    std::ostringstream str;
-    str << "Axis "  << i;
-    try {
-      if (joystick.js_cfg.buttons.size() > 0  and ! joystick.js_cfg.axes.at(i).empty())
-      {
-        str << " [" << joystick.js_cfg.axes[i] << "] ";
-      }
-    } catch (const std::out_of_range& e) {}
-    str << ": ";
-    auto label = Gtk::manage(new Gtk::Label(str.str()));
+    auto label = Gtk::manage(new Gtk::Label(get_axis_label(i)));
     label->set_xalign(0.0);
+    axis_labels.push_back(label);
 
     Gtk::ProgressBar& progressbar = *Gtk::manage(new Gtk::ProgressBar());
     progressbar.set_fraction(0.5);
 
+    auto badge = Gtk::manage(new Gtk::Label());
+    badge->set_use_markup(true);
+    axis_badges.push_back(badge);
+
     //Each column must have at most 10 axes
-    int x = (i/10)*2;
+    int x = (i/10)*3;
     int y = i%10;
 
     axis_table.attach(*label, x, x+1, y, y+1, Gtk::FILL, Gtk::SHRINK);
     axis_table.attach(progressbar, x+1, x+2, y, y+1, Gtk::FILL|Gtk::EXPAND, Gtk::EXPAND);
+    axis_table.attach(*badge, x+2, x+3, y, y+1, Gtk::FILL, Gtk::SHRINK);
 
     axes.push_back(&progressbar);
   }
+  reset_drift_monitor();
 
   int width = 32;
   int char_width = 10;
-  if (joystick.js_cfg.button_maxlen > 0)
+  if (joystick.js_cfg->button_maxlen > 0)
   {
-    width += joystick.js_cfg.button_maxlen * char_width;
+    width += joystick.js_cfg->button_maxlen * char_width;
   }
     
   for(int i = 0; i < joystick.get_button_count(); ++i)
@@ -110,19 +120,12 @@ JoystickTestWidget::JoystickTestWidget(JoystickGui& gui, Joystick& joystick_, bo
     int x = i / 10;
     int y = i % 10;
 
-    std::ostringstream str;
-    str << i;
-    try {
-      if (joystick.js_cfg.buttons.size() > 0  and ! joystick.js_cfg.buttons[i].empty())
-      {
-        str << " - " << joystick.js_cfg.buttons[i];
-      }
-    } catch (const std::out_of_range& e) {}
     auto* button = Gtk::manage(new ButtonWidget());
-    auto label = Gtk::manage(new Gtk::Label(str.str()));
+    auto label = Gtk::manage(new Gtk::Label(get_button_label(i)));
     label->set_xalign(0.0);
     label->set_margin_start(10);
     label->set_margin_end(10);
+    button_labels.push_back(label);
 
     button->add(*label);
     button_table.attach(*button, x, x+1, y, y+1, Gtk::EXPAND | Gtk::FILL, Gtk::EXPAND);
@@ -135,6 +138,8 @@ JoystickTestWidget::JoystickTestWidget(JoystickGui& gui, Joystick& joystick_, bo
 
   buttonbox.add(mapping_button);
   buttonbox.add(calibration_button);
+  buttonbox.add(capture_button);
+  buttonbox.add(profile_button);
   buttonbox.add(close_button);
 
   test_hbox.pack_start(axis_frame,   Gtk::PACK_EXPAND_WIDGET);
@@ -157,7 +162,238 @@ JoystickTestWidget::JoystickTestWidget(JoystickGui& gui, Joystick& joystick_, bo
   m_verbose and std::cout << "joystick.get_js_type(): " << joystick.get_js_type() << std::endl;
   m_verbose and std::cout << "joystick.get_axis_count(): " << joystick.get_axis_count() << std::endl;
   
-  // NOTE: remember to add any new types added here to the list in "data/README.txt" so users can create their own config files
+  setup_layout();
+  travel_pending.assign(travel_widgets.size(), 0);
+  travel_check.set_sensitive(!travel_widgets.empty());
+  travel_check.set_tooltip_text("Mark where the triggers start moving (green), saturate (red), "
+                                "where presses start and releases end (blue, orange), and the values "
+                                "seen while pressing and releasing. Let go of the triggers before turning this on.");
+
+  if (!m_simple_ui)
+  {
+    axis_vbox.pack_start(stick_hbox, Gtk::PACK_SHRINK);
+    axis_vbox.pack_start(travel_check, Gtk::PACK_SHRINK);
+  }
+
+  axis_vbox.add(axis_table);
+  axis_frame.add(axis_vbox);
+
+  button_frame.add(button_table);
+
+  joystick.axis_move.connect(sigc::mem_fun(this, &JoystickTestWidget::axis_move));
+  joystick.button_move.connect(sigc::mem_fun(this, &JoystickTestWidget::button_move));
+
+  calibration_button.signal_clicked().connect(sigc::mem_fun(this, &JoystickTestWidget::on_calibrate));
+  mapping_button.signal_clicked().connect(sigc::mem_fun(this, &JoystickTestWidget::on_mapping));
+  capture_button.signal_clicked().connect(sigc::mem_fun(this, &JoystickTestWidget::on_capture));
+  profile_button.signal_clicked().connect(sigc::mem_fun(this, &JoystickTestWidget::on_save_profile));
+  travel_check.signal_toggled().connect(sigc::mem_fun(this, &JoystickTestWidget::on_travel_toggled));
+  close_button.signal_clicked().connect([this]{ hide(); });
+
+  if (UdevMonitor* udev_monitor = Main::current()->get_udev_monitor())
+  {
+    udev_monitor->signal_joystick_event.connect(sigc::mem_fun(this, &JoystickTestWidget::on_udev_js_event));
+  }
+
+  close_button.grab_focus();
+}
+
+std::string
+JoystickTestWidget::get_axis_label(int i) const
+{
+  std::ostringstream str;
+  str << "Axis "  << i;
+  try {
+    if (joystick.js_cfg->buttons.size() > 0  and ! joystick.js_cfg->axes.at(i).empty())
+    {
+      str << " [" << joystick.js_cfg->axes[i] << "] ";
+    }
+  } catch (const std::out_of_range& e) {}
+  str << ": ";
+  return str.str();
+}
+
+std::string
+JoystickTestWidget::get_button_label(int i) const
+{
+  std::ostringstream str;
+  str << i;
+  try {
+    if (joystick.js_cfg->buttons.size() > 0  and ! joystick.js_cfg->buttons.at(i).empty())
+    {
+      str << " - " << joystick.js_cfg->buttons[i];
+    }
+  } catch (const std::out_of_range& e) {}
+  return str.str();
+}
+
+void
+JoystickTestWidget::update_label()
+{
+  if (connected)
+    label.set_label(label_base + label_errors);
+  else
+    label.set_label(label_base + label_errors + "\n<span foreground='red'>DISCONNECTED</span>");
+}
+
+void
+JoystickTestWidget::reset_drift_monitor()
+{
+  std::vector<Joystick::CalibrationData> calibration = joystick.get_calibration();
+  for(int i = 0; i < joystick.get_axis_count(); ++i)
+  {
+    // the deadzone hides noise and drift up to its half width, scale
+    // that to output units so 8 bit axes are judged the same
+    int noise_limit = 256;
+    if (i < static_cast<int>(calibration.size()) && calibration[i].calibrate &&
+        calibration[i].center_min > calibration[i].range_min)
+    {
+      const Joystick::CalibrationData& axis = calibration[i];
+      int deadzone = static_cast<int>(static_cast<int64_t>(axis.center_max - axis.center_min) * 32767 /
+                                      (2 * (axis.center_min - axis.range_min)));
+      noise_limit = std::max(noise_limit, deadzone);
+    }
+    drift_monitor.set_limits(i, noise_limit, std::max(1024, 2 * noise_limit));
+  }
+
+  drift_monitor.reset();
+  for(int i = 0; i < joystick.get_axis_count(); ++i)
+  {
+    update_badge(i);
+  }
+}
+
+void
+JoystickTestWidget::update_badge(int axis)
+{
+  int status = drift_monitor.get_status(axis);
+  if (status == DriftMonitor::STATUS_OK)
+  {
+    axis_badges[axis]->set_label("");
+    axis_badges[axis]->set_tooltip_text("");
+    return;
+  }
+
+  std::string badge;
+  if (status & DriftMonitor::STATUS_DRIFTING)
+    badge += "<span foreground='orange'>drift</span> ";
+  if (status & DriftMonitor::STATUS_NOISY)
+    badge += "<span foreground='red'>noise</span>";
+  axis_badges[axis]->set_label(badge);
+
+  std::ostringstream str;
+  str << "center " << drift_monitor.get_center(axis)
+      << " (settled at " << drift_monitor.get_reference(axis) << ")"
+      << ", noise " << static_cast<int>(drift_monitor.get_noise(axis));
+  axis_badges[axis]->set_tooltip_text(str.str());
+}
+
+void
+JoystickTestWidget::update_button_label(int button)
+{
+  const ButtonChatterAnalyzer::Stats& stats = button_chatter.get_stats(button);
+  std::string text = Glib::Markup::escape_text(get_button_label(button));
+  if (stats.chattering)
+  {
+    button_labels[button]->set_markup("<span foreground='orange'>" + text + " (chatter)</span>");
+
+    std::ostringstream str;
+    str << stats.bounces << " bounces on " << stats.presses << " presses, "
+        << "shortest gap " << stats.min_interval << " ms";
+    buttons[button]->set_tooltip_text(str.str());
+  }
+  else
+  {
+    button_labels[button]->set_markup(text);
+    buttons[button]->set_tooltip_text("");
+  }
+}
+
+void
+JoystickTestWidget::update_travel(int axis, ThrottleWidget& widget, bool summary)
+{
+  const TriggerTravelAnalyzer::Stats& stats = trigger_travel.get_stats(axis);
+  if (stats.presses == 0)
+    return;
+
+  uint32_t peak = 1;
+  for(int i = 0; i < TriggerTravelAnalyzer::curve_size; ++i)
+  {
+    peak = std::max(peak, std::max(stats.press_curve[i], stats.release_curve[i]));
+  }
+
+  // reused, so redrawing doesn't allocate once the curves have their size
+  ThrottleWidget::Travel& travel = travel_overlay;
+  travel.first_movement = stats.first_movement / 32767.0;
+  travel.saturation = stats.saturation / 32767.0;
+  travel.press = trigger_travel.get_press_threshold(axis) / 32767.0;
+  travel.release = trigger_travel.get_release_threshold(axis) / 32767.0;
+  travel.press_curve.resize(TriggerTravelAnalyzer::curve_size);
+  travel.release_curve.resize(TriggerTravelAnalyzer::curve_size);
+  for(int i = 0; i < TriggerTravelAnalyzer::curve_size; ++i)
+  {
+    travel.press_curve[i] = static_cast<double>(stats.press_curve[i]) / peak;
+    travel.release_curve[i] = static_cast<double>(stats.release_curve[i]) / peak;
+  }
+  widget.set_travel(travel);
+
+  if (!summary)
+    return;
+
+  std::ostringstream str;
+  str << "rest " << stats.rest
+      << ", first movement " << stats.first_movement
+      << ", saturation " << stats.saturation
+      << ", press at " << trigger_travel.get_press_threshold(axis)
+      << ", release at " << trigger_travel.get_release_threshold(axis)
+      << ", hysteresis " << trigger_travel.get_hysteresis(axis)
+      << " (" << stats.presses << " presses)";
+  widget.set_tooltip_text(str.str());
+  m_verbose and std::cout << joystick.get_filename() << ": axis " << axis << ": " << str.str() << std::endl;
+}
+
+bool
+JoystickTestWidget::on_travel_timeout()
+{
+  for(size_t i = 0; i < travel_widgets.size() && i < travel_pending.size(); ++i)
+  {
+    if (travel_pending[i])
+    {
+      update_travel(travel_widgets[i].first, *travel_widgets[i].second,
+                    (travel_pending[i] & TRAVEL_SUMMARY) != 0);
+      travel_pending[i] = 0;
+    }
+  }
+  return false;
+}
+
+void
+JoystickTestWidget::reset_trigger_travel()
+{
+  // triggers at rest don't send events, so take rest from the current
+  // state, the tooltip asks to let go before turning this on
+  trigger_travel.reset();
+  travel_timeout.disconnect();
+  travel_pending.assign(travel_widgets.size(), 0);
+  for(auto& it : travel_widgets)
+  {
+    trigger_travel.set_rest(it.first, joystick.get_axis_state(it.first));
+    it.second->clear_travel();
+    it.second->set_has_tooltip(false);
+  }
+}
+
+void
+JoystickTestWidget::on_travel_toggled()
+{
+  reset_trigger_travel();
+}
+
+void
+JoystickTestWidget::setup_layout()
+{
+  // NOTE: remember to add any new types added here to the list in "data/README.txt" so users can create their own config files,
+  // and to is_known_js_type() so the config checker accepts them
   if (joystick.get_js_type() == "ps4-dualshock4")
     setup_dualshock4_equiv();
   else if (joystick.get_js_type() == "ps3-sixaxis")
@@ -166,6 +402,9 @@ JoystickTestWidget::JoystickTestWidget(JoystickGui& gui, Joystick& joystick_, bo
     setup_dualshock2_equiv();
   else if (joystick.get_js_type() == "xbox360")
     setup_xbox360_equiv();
+  else if (!joystick.js_cfg->stick_axes.empty() || !joystick.js_cfg->trigger_axes.empty())
+    // layout that came with the config, e.g. from an SDL mapping
+    setup_joystick_widgets(joystick.js_cfg->stick_axes.size() / 2, joystick.js_cfg->stick_axes, joystick.js_cfg->trigger_axes);
   else
   {
     switch(joystick.get_axis_count())
@@ -189,6 +428,7 @@ JoystickTestWidget::JoystickTestWidget(JoystickGui& gui, Joystick& joystick_, bo
       axis_callbacks[1].connect(sigc::mem_fun(stick1_widget, &AxisWidget::set_y_axis));
       axis_callbacks[2].connect(sigc::mem_fun(rudder_widget, &RudderWidget::set_pos));
       axis_callbacks[3].connect(sigc::mem_fun(throttle_widget, &ThrottleWidget::set_pos));
+      travel_widgets.push_back(std::make_pair(3, &throttle_widget));
       axis_callbacks[4].connect(sigc::mem_fun(stick3_widget, &AxisWidget::set_x_axis));
       axis_callbacks[5].connect(sigc::mem_fun(stick3_widget, &AxisWidget::set_y_axis));
       break;
@@ -206,28 +446,42 @@ JoystickTestWidget::JoystickTestWidget(JoystickGui& gui, Joystick& joystick_, bo
       std::cout << "Graphical representation for this joystick has not been configured yet." << std::endl;
     }
   }
+}
 
-  if (!m_simple_ui)
+void
+JoystickTestWidget::apply_config()
+{
+  for(size_t i = 0; i < axis_labels.size(); ++i)
   {
-    axis_vbox.pack_start(stick_hbox, Gtk::PACK_SHRINK);
+    axis_labels[i]->set_text(get_axis_label(i));
+  }
+  for(size_t i = 0; i < button_labels.size(); ++i)
+  {
+    update_button_label(i);
   }
 
-  axis_vbox.add(axis_table);
-  axis_frame.add(axis_vbox);
-
-  button_frame.add(button_table);
-
-  joystick.axis_move.connect(sigc::mem_fun(this, &JoystickTestWidget::axis_move));
-  joystick.button_move.connect(sigc::mem_fun(this, &JoystickTestWidget::button_move));
-
-  calibration_button.signal_clicked().connect(sigc::mem_fun(this, &JoystickTestWidget::on_calibrate));
-  mapping_button.signal_clicked().connect(sigc::mem_fun(this, &JoystickTestWidget::on_mapping));
-  close_button.signal_clicked().connect([this]{ hide(); });
-
-  udev_monitor.reset(new UdevMonitor());
-  udev_monitor->signal_joystick_event.connect(sigc::mem_fun(this, &JoystickTestWidget::on_udev_js_event));
-
-  close_button.grab_focus();
+  // tear down the old layout, fresh signals drop all the connections
+  // to the stick widgets
+  for(auto* child : stick_hbox.get_children())
+  {
+    stick_hbox.remove(*child);
+  }
+  for(auto& callback : axis_callbacks)
+  {
+    callback = sigc::signal<void, double>();
+  }
+  for(auto& it : travel_widgets)
+  {
+    it.second->clear_travel();
+  }
+  travel_widgets.clear();
+
+  label_errors.clear();
+  setup_layout();
+  reset_trigger_travel();
+  travel_check.set_sensitive(!travel_widgets.empty());
+  update_label();
+  stick_hbox.show_all();
 }
 
 void
@@ -253,25 +507,27 @@ JoystickTestWidget::setup_joystick_widgets(const u_int sticks, const std::vector
   catch (const std::out_of_range& e) {
     std::cout << "joystick configuration error. Some axis data missing or out of range." << std::endl;
     m_verbose and std::cout << e.what() << std::endl;
-    label_base = label_base + "\n<span foreground='red'>ERROR: axis config data</span>";
-    label.set_label(label_base);
+    label_errors += "\n<span foreground='red'>ERROR: axis config data</span>";
+    update_label();
   }
     
   try {
     if (triggers.size() >= 1) {
       stick_hbox.pack_start(left_trigger_widget, Gtk::PACK_EXPAND_PADDING);
       axis_callbacks.at(triggers.at(0)).connect(sigc::mem_fun(left_trigger_widget, &ThrottleWidget::set_pos));
+      travel_widgets.push_back(std::make_pair(triggers.at(0), &left_trigger_widget));
     }
     if (triggers.size() >= 2) {
       stick_hbox.pack_start(right_trigger_widget, Gtk::PACK_EXPAND_PADDING);
       axis_callbacks.at(triggers.at(1)).connect(sigc::mem_fun(right_trigger_widget, &ThrottleWidget::set_pos));
+      travel_widgets.push_back(std::make_pair(triggers.at(1), &right_trigger_widget));
     }
   }
   catch (const std::out_of_range& e) {
     std::cout << "joystick configuration error. Some trigger data missing or out of range." << std::endl;
     m_verbose and std::cout << e.what() << std::endl;
-    label_base = label_base + "\n<span foreground='red'>ERROR: trigger config data</span>";
-    label.set_label(label_base);
+    label_errors += "\n<span foreground='red'>ERROR: trigger config data</span>";
+    update_label();
   }
 }
   
@@ -309,6 +565,42 @@ JoystickTestWidget::axis_move(int number, int value)
   str << value;
   axes.at(number)->set_text(str.str());
   axis_callbacks[number](value / 32767.0);
+
+  if (drift_monitor.update(number, value))
+  {
+    int status = drift_monitor.get_status(number);
+    m_verbose and std::cout << joystick.get_filename() << ": axis " << number << ": "
+                            << (status == DriftMonitor::STATUS_OK ? "ok," : "")
+                            << ((status & DriftMonitor::STATUS_DRIFTING) ? "drifting," : "")
+                            << ((status & DriftMonitor::STATUS_NOISY) ? "noisy," : "")
+                            << " center " << drift_monitor.get_center(number)
+                            << " (settled at " << drift_monitor.get_reference(number) << ")"
+                            << " noise " << static_cast<int>(drift_monitor.get_noise(number)) << std::endl;
+    update_badge(number);
+  }
+
+  if (travel_check.get_active())
+  {
+    for(size_t i = 0; i < travel_widgets.size(); ++i)
+    {
+      if (travel_widgets[i].first == number && joystick.is_initial_event())
+      {
+        // the state after reopening on a reconnect
+        trigger_travel.resume(number, value);
+      }
+      else if (travel_widgets[i].first == number)
+      {
+        // the summary only changes with the thresholds and extremes,
+        // the curves with every event
+        bool changed = trigger_travel.add(number, value);
+        travel_pending[i] |= TRAVEL_CURVES | (changed ? TRAVEL_SUMMARY : 0);
+        if (!travel_timeout.connected())
+        {
+          travel_timeout = Glib::signal_timeout().connect(sigc::mem_fun(this, &JoystickTestWidget::on_travel_timeout), 16);
+        }
+      }
+    }
+  }
 }
 
 void
@@ -318,6 +610,21 @@ JoystickTestWidget::button_move(int number, bool value)
     buttons.at(number)->set_active(true);
   else
     buttons.at(number)->set_active(false);
+
+  if (joystick.is_initial_event())
+  {
+    // the state after opening, or reopening on a reconnect
+    button_chatter.resume(number, value);
+  }
+  else if (button_chatter.add(number, value, joystick.get_event_time()))
+  {
+    const ButtonChatterAnalyzer::Stats& stats = button_chatter.get_stats(number);
+    m_verbose and std::cout << joystick.get_filename() << ": button " << number << ": "
+                            << (stats.chattering ? "chattering" : "ok") << ", "
+                            << stats.bounces << " bounces on " << stats.presses << " presses, "
+                            << "shortest gap " << stats.min_interval << " ms" << std::endl;
+    update_button_label(number);
+  }
 }
 
 void
@@ -333,26 +640,56 @@ JoystickTestWidget::on_mapping()
 }
 
 void
-JoystickTestWidget::on_udev_js_event(const std::string& action, const std::string& devnode)
+JoystickTestWidget::on_capture()
 {
-  m_verbose and  std::cout << "joystick_test_widget " << action << ": " << devnode << std::endl;
-  if (devnode == joystick.get_filename()) {
-    if (action == "remove") {
-      connected = false;
-      label.set_label(label_base + "\n<span foreground='red'>DISCONNECTED</span>");
-      m_verbose and std::cout << "joystick disconnected: "  <<  joystick.get_name() << std::endl;
-    }
-    else if (action == "add") {
-      if (joystick.reconnected()) {
+  if (connected) m_gui.show_capture_dialog();
+}
+
+void
+JoystickTestWidget::on_save_profile()
+{
+  if (connected) m_gui.show_save_profile_dialog();
+}
+
+void
+JoystickTestWidget::on_udev_js_event(const std::string& action, const std::string& devnode, const std::string& stable_id)
+{
+  m_verbose and  std::cout << "joystick_test_widget " << action << ": " << devnode << " " << stable_id << std::endl;
+  if (action == "remove" && devnode == joystick.get_filename()) {
+    connected = false;
+    update_label();
+    m_verbose and std::cout << "joystick disconnected: "  <<  joystick.get_name() << std::endl;
+  }
+  else if (action == "add" && !connected) {
+    // Match on the stable id, the device might come back under a
+    // different jsX, fall back to the device file when udev doesn't
+    // provide one
+    bool same_device = (joystick.get_stable_id().empty() || stable_id.empty())
+      ? devnode == joystick.get_filename()
+      : stable_id == joystick.get_stable_id();
+
+    if (same_device) {
+      std::string old_filename = joystick.get_filename();
+      if (joystick.reconnect(devnode)) {
         connected = true;
-        m_verbose and std::cout << "joystick re-connected: "  << joystick.get_name()  << std::endl;
-        label.set_label(label_base);
+        reset_drift_monitor();
+        m_verbose and std::cout << "joystick re-connected: "  << joystick.get_name() << " " << devnode << std::endl;
+        if (old_filename != devnode) {
+          Glib::ustring::size_type pos = label_base.find("Device: " + old_filename);
+          if (pos != Glib::ustring::npos) {
+            label_base.replace(pos + 8, old_filename.size(), devnode);
+          }
+          Main::current()->on_device_renamed(old_filename, devnode);
+        }
+        update_label();
       //label.set_label(label_base + "\n<span foreground='green'>reconnected</span>");
       }
     }
-    calibration_button.set_sensitive(connected);
-    mapping_button.set_sensitive(connected);
   }
+  calibration_button.set_sensitive(connected);
+  mapping_button.set_sensitive(connected);
+  capture_button.set_sensitive(connected);
+  profile_button.set_sensitive(connected);
 }
 
 /* EOF */
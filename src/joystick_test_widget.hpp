@@ -27,6 +27,7 @@
 #include <gtkmm/table.h>
 #include <gtkmm/buttonbox.h>
 #include <gtkmm/button.h>
+#include <gtkmm/checkbutton.h>
 #include <gtkmm/dialog.h>
 #include <gtkmm/alignment.h>
 #include <gtkmm/comboboxtext.h>
@@ -36,6 +37,9 @@
 #include "throttle_widget.hpp"
 #include "rudder_widget.hpp"
 #include "axis_widget.hpp"
+#include "button_chatter.hpp"
+#include "drift_monitor.hpp"
+#include "trigger_travel.hpp"
 
 #include "udev_monitor.hpp"
 
@@ -56,6 +60,7 @@ private:
   Gtk::Alignment alignment;
   Gtk::Label label;
   Glib::ustring label_base;
+  Glib::ustring label_errors; // problems with the config, shown below label_base
 
   Gtk::Frame axis_frame;
   Gtk::VBox  axis_vbox;
@@ -67,6 +72,8 @@ private:
 
   Gtk::Button mapping_button;
   Gtk::Button calibration_button;
+  Gtk::Button capture_button;
+  Gtk::Button profile_button;
   Gtk::Button close_button;
   Gtk::HButtonBox buttonbox;
 
@@ -80,15 +87,31 @@ private:
   ThrottleWidget left_trigger_widget;
   ThrottleWidget right_trigger_widget;
 
+  Gtk::CheckButton travel_check;
+  // the trigger and throttle axes of the current layout
+  std::vector<std::pair<int, ThrottleWidget*> > travel_widgets;
+  // per entry of travel_widgets, what changed since the overlay was
+  // drawn, the overlays are redrawn at most once per frame
+  enum { TRAVEL_CURVES = 1, TRAVEL_SUMMARY = 2 };
+  std::vector<int> travel_pending;
+  sigc::connection travel_timeout;
+  ThrottleWidget::Travel travel_overlay;
+
   std::vector<Gtk::ProgressBar*> axes;
   std::vector<ButtonWidget*>     buttons;
+  std::vector<Gtk::Label*>       axis_labels;
+  std::vector<Gtk::Label*>       button_labels;
+  std::vector<Gtk::Label*>       axis_badges;
+
+  DriftMonitor drift_monitor;
+  ButtonChatterAnalyzer button_chatter;
+  TriggerTravelAnalyzer trigger_travel;
 
   Glib::RefPtr<Gdk::Pixbuf> button_on;
   Glib::RefPtr<Gdk::Pixbuf> button_off;
 
   std::vector<sigc::signal<void, double> > axis_callbacks;
 
-  std::unique_ptr<UdevMonitor> udev_monitor;
 
 public:
   JoystickTestWidget(JoystickGui& gui, Joystick& joystick, bool simple_ui);
@@ -98,17 +121,37 @@ public:
 
   void on_calibrate();
   void on_mapping();
+  void on_capture();
+  void on_save_profile();
+
+  /** Updates the axis and button labels and the stick layout after
+      joystick.js_cfg changed, without reopening the device */
+  void apply_config();
+
+  /** Starts measuring axis noise and drift from scratch, with limits
+      taken from the current calibration */
+  void reset_drift_monitor();
 
 private:
   JoystickTestWidget(const JoystickTestWidget&);
   JoystickTestWidget& operator=(const JoystickTestWidget&);
+  std::string get_axis_label(int i) const;
+  std::string get_button_label(int i) const;
+  void update_label();
+  void update_badge(int axis);
+  void update_button_label(int button);
+  void update_travel(int axis, ThrottleWidget& widget, bool summary);
+  void reset_trigger_travel();
+  void on_travel_toggled();
+  bool on_travel_timeout();
+  void setup_layout();
   void setup_joystick_widgets(const u_int sticks, const std::vector<u_int>& axes, const std::vector<u_int>& triggers);
   void setup_sixaxis_equiv();
   void setup_dualshock2_equiv();
   void setup_dualshock4_equiv();
   void setup_xbox360_equiv();
 
-  void on_udev_js_event(const std::string& action, const std::string& devnode);
+  void on_udev_js_event(const std::string& action, const std::string& devnode, const std::string& stable_id);
 };
 
 #endif
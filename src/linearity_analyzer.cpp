@@ -0,0 +1,304 @@
+/*
+**  jstest-gtk - A graphical joystick tester
+**  Copyright (C) 2025 Raphael Rosch <jstest-bugs@insaner.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <math.h>
+
+#include "linearity_analyzer.hpp"
+
+namespace {
+
+// a pause longer than this is the user stopping, not a sticky spot
+const int64_t max_dwell_us = 100000;
+
+// bins that held more than this times the median count as sticky
+const uint32_t sticky_factor = 4;
+
+// bins on each side a bin is compared with
+const int neighbourhood = 8;
+
+} // namespace
+
+LinearityAnalyzer::LinearityAnalyzer() :
+  m_dwell(4096),
+  m_has_last(false),
+  m_last_value(0),
+  m_last_time(0),
+  m_events(0)
+{
+}
+
+void
+LinearityAnalyzer::clear()
+{
+  m_dwell.clear();
+  m_has_last = false;
+  m_events = 0;
+}
+
+void
+LinearityAnalyzer::add(int value, int64_t time_us)
+{
+  if (m_has_last)
+  {
+    // +1 so that values that were passed within the same
+    // microsecond still count as reported
+    int64_t dwell = std::min(std::max(time_us - m_last_time, int64_t(0)), max_dwell_us);
+    m_dwell.add(m_last_value, static_cast<uint32_t>(dwell + 1));
+  }
+
+  m_has_last = true;
+  m_last_value = value;
+  m_last_time = time_us;
+  m_events += 1;
+}
+
+uint32_t
+LinearityAnalyzer::local_median(int bin, int first, int last) const
+{
+  uint32_t values[2 * neighbourhood];
+  int count = 0;
+  for(int i = std::max(first + 1, bin - neighbourhood); i <= std::min(last - 1, bin + neighbourhood); ++i)
+  {
+    if (i != bin && m_dwell.bin(i) > 0)
+      values[count++] = m_dwell.bin(i);
+  }
+
+  if (count == 0)
+    return m_dwell.bin(bin);
+
+  std::nth_element(values, values + count / 2, values + count);
+  return values[count / 2];
+}
+
+LinearityReport
+LinearityAnalyzer::analyze(int segments) const
+{
+  LinearityReport report;
+  report.bin_width = m_dwell.bin_width();
+  report.events = m_events;
+  report.max_error = 0.0;
+  report.fit_error = 0.0;
+  report.calibration.center_min = report.calibration.center_max = 0;
+  report.calibration.range_min = report.calibration.range_max = 0;
+  report.calibration.confidence = 0.0;
+  report.calibration.problem = "not moved";
+
+  int first = 0;
+  int last = m_dwell.bin_count() - 1;
+  while (first <= last && m_dwell.bin(first) == 0) ++first;
+  while (last >= first && m_dwell.bin(last) == 0) --last;
+  if (last - first < 2)
+  {
+    return report;
+  }
+
+  // the sweep is taken to be even, so time is position, except for
+  // the waiting at the end stops
+  std::vector<double> weights(last - first + 1);
+  double total = 0.0;
+  for(int i = first; i <= last; ++i)
+  {
+    uint32_t weight = m_dwell.bin(i);
+    if (i == first || i == last)
+      weight = std::min(weight, local_median(i, first, last));
+    weights[i - first] = weight;
+    total += weight;
+  }
+
+  const int width = m_dwell.bin_width();
+  const int range_min = m_dwell.bin_start(first);
+  const int range_max = m_dwell.bin_start(last) + width - 1;
+  const double travel = range_max - range_min + 1;
+
+  // breakpoints where the position crosses k/segments, interpolated
+  // within the bin
+  report.breakpoints.push_back(range_min);
+  double position = 0.0;
+  int k = 1;
+  for(size_t i = 0; i < weights.size() && k < segments; ++i)
+  {
+    while (k < segments && weights[i] > 0 && position + weights[i] >= total * k / segments)
+    {
+      double fraction = (total * k / segments - position) / weights[i];
+      report.breakpoints.push_back(range_min + static_cast<int>((i + fraction) * width));
+      ++k;
+    }
+    position += weights[i];
+  }
+  while (static_cast<int>(report.breakpoints.size()) < segments)
+  {
+    report.breakpoints.push_back(range_max);
+  }
+  report.breakpoints.push_back(range_max);
+
+  // compare the measured position at each bin end with the straight
+  // line and with the curve through the breakpoints
+  position = 0.0;
+  size_t segment = 0;
+  for(size_t i = 0; i < weights.size(); ++i)
+  {
+    position += weights[i];
+    double measured = position / total;
+    double raw = range_min + (i + 1) * width;
+
+    report.max_error = std::max(report.max_error, fabs(measured - (raw - range_min) / travel));
+
+    while (segment + 2 < report.breakpoints.size() && raw > report.breakpoints[segment + 1])
+      ++segment;
+    double lo = report.breakpoints[segment];
+    double hi = report.breakpoints[segment + 1];
+    double fitted = (segment + (hi > lo ? std::min(std::max((raw - lo) / (hi - lo), 0.0), 1.0) : 1.0)) / segments;
+    report.fit_error = std::max(report.fit_error, fabs(measured - fitted));
+  }
+
+  // runs of empty bins and of bins held much longer than their
+  // neighbours, a nonlinear curve changes the time per bin only slowly
+  for(int i = first; i <= last; ++i)
+  {
+    std::vector<std::pair<int, int> >* ranges = nullptr;
+    if (m_dwell.bin(i) == 0)
+      ranges = &report.gaps;
+    else if (i != first && i != last && m_dwell.bin(i) > sticky_factor * local_median(i, first, last))
+      ranges = &report.sticky;
+
+    if (ranges)
+    {
+      int start = m_dwell.bin_start(i);
+      int end = start + width - 1;
+      if (!ranges->empty() && ranges->back().second + 1 == start)
+        ranges->back().second = end;
+      else
+        ranges->push_back(std::make_pair(start, end));
+    }
+  }
+
+  // joydev only has a slope on each side of the center
+  AxisCalibrationEstimate& calibration = report.calibration;
+  calibration.range_min = range_min;
+  calibration.range_max = range_max;
+  calibration.center_min = calibration.center_max = (segments % 2 == 0)
+    ? report.breakpoints[segments / 2]
+    : (report.breakpoints[segments / 2] + report.breakpoints[segments / 2 + 1]) / 2;
+  calibration.confidence = 1.0;
+  calibration.problem.clear();
+
+  auto limit = [&calibration](double confidence, const char* problem) {
+    if (confidence < calibration.confidence)
+    {
+      calibration.confidence = std::max(confidence, 0.0);
+      calibration.problem = problem;
+    }
+  };
+  limit(m_events / 500.0, "too few samples");
+  if (report.max_error > 0.02)
+    limit(1.0 - 5.0 * report.max_error, "not linear");
+  if (!report.sticky.empty())
+    limit(0.5, "sticky");
+  if (!report.gaps.empty())
+    limit(0.5, "missing codes");
+
+  return report;
+}
+
+#ifdef __TEST__
+
+// g++ -std=c++11 -O2 -D__TEST__ linearity_analyzer.cpp streaming_histogram.o -o linearity-analyzer-test
+
+#include <iostream>
+
+namespace {
+
+// sweeps a 10 bit pot back and forth at an even speed, \a response
+// maps the position 0..1 to the raw value
+template<typename F>
+void sweep(LinearityAnalyzer& analyzer, F response, int sweeps = 6)
+{
+  int64_t t = 0;
+  int last = -1;
+  for(int s = 0; s < sweeps; ++s)
+  {
+    for(int step = 0; step <= 20000; ++step)
+    {
+      double x = step / 20000.0;
+      if (s % 2) x = 1.0 - x;
+      int raw = response(x);
+      if (raw != last)
+      {
+        analyzer.add(raw, t);
+        last = raw;
+      }
+      t += 250; // 5 s per sweep
+    }
+  }
+}
+
+void print(const char* name, const LinearityReport& report)
+{
+  std::cout << name << ": bin width " << report.bin_width
+            << ", error " << report.max_error << " (fit " << report.fit_error << ")"
+            << ", " << report.gaps.size() << " gaps, " << report.sticky.size() << " sticky"
+            << ", confidence " << report.calibration.confidence << " " << report.calibration.problem << "\n  ";
+  for(auto breakpoint : report.breakpoints)
+    std::cout << breakpoint << " ";
+  std::cout << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  bool ok = true;
+
+  LinearityAnalyzer linear;
+  sweep(linear, [](double x) { return static_cast<int>(x * 1023 + 0.5); });
+  LinearityReport report = linear.analyze();
+  print("linear", report);
+  ok = ok && report.max_error < 0.01 && report.gaps.empty() && report.sticky.empty();
+  ok = ok && abs(report.calibration.center_min - 512) < 8 && report.calibration.confidence > 0.9;
+
+  // audio taper pot
+  LinearityAnalyzer curved;
+  sweep(curved, [](double x) { return static_cast<int>(pow(x, 1.5) * 1023 + 0.5); });
+  report = curved.analyze();
+  print("curved", report);
+  ok = ok && report.max_error > 0.1 && report.fit_error < 0.02;
+  ok = ok && abs(report.breakpoints[4] - static_cast<int>(pow(0.5, 1.5) * 1023)) < 8;
+
+  // worn track: codes 600..620 missing, stuck at 300 for a bit, both
+  // leave a gap and a value held for too long
+  LinearityAnalyzer worn;
+  sweep(worn, [](double x) {
+      int raw = static_cast<int>(x * 1023 + 0.5);
+      if (raw >= 600 && raw <= 620) raw = 621;
+      if (raw >= 300 && raw < 330) raw = 300;
+      return raw;
+    });
+  report = worn.analyze();
+  print("worn", report);
+  ok = ok && report.gaps.size() == 2 && report.gaps[0].first == 301 && report.gaps[0].second == 329;
+  ok = ok && report.gaps[1].first == 600 && report.gaps[1].second == 620;
+  ok = ok && report.sticky.size() == 2 && report.sticky[0].first == 300 && report.sticky[1].first == 621;
+
+  std::cout << (ok ? "ok" : "WRONG") << std::endl;
+  return ok ? 0 : 1;
+}
+
+#endif
+
+/* EOF */
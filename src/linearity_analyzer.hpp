@@ -0,0 +1,82 @@
+/*
+**  jstest-gtk - A graphical joystick tester
+**  Copyright (C) 2025 Raphael Rosch <jstest-bugs@insaner.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HEADER_JSTEST_GTK_LINEARITY_ANALYZER_HPP
+#define HEADER_JSTEST_GTK_LINEARITY_ANALYZER_HPP
+
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+#include "streaming_histogram.hpp"
+
+struct LinearityReport
+{
+  int bin_width;    // 1 when every raw code has its own bin
+  uint64_t events;
+
+  /** Raw values at equally spaced positions from one end of the travel
+      to the other, the piecewise-linear response curve */
+  std::vector<int> breakpoints;
+
+  /** Largest distance of the measured response from a straight line
+      and from the piecewise-linear curve, as a fraction of the travel */
+  double max_error;
+  double fit_error;
+
+  /** Raw ranges that never got reported (missing codes when bin_width
+      is 1) and ranges the axis got stuck on */
+  std::vector<std::pair<int, int> > gaps;
+  std::vector<std::pair<int, int> > sticky;
+
+  /** The curve reduced to the two segments joydev supports */
+  AxisCalibrationEstimate calibration;
+};
+
+/** Measures the response of an axis that is swept slowly and evenly
+    from end to end. Each raw value is credited with the time until the
+    next event in a fixed size histogram, so with an even sweep the
+    accumulated time is the physical position and the histogram is the
+    response curve. Nothing but the histogram is kept. */
+class LinearityAnalyzer
+{
+private:
+  StreamingHistogram m_dwell; // microseconds, 4096 bins so 12 bit axes stay exact
+  bool m_has_last;
+  int m_last_value;
+  int64_t m_last_time;
+  uint64_t m_events;
+
+public:
+  LinearityAnalyzer();
+
+  void add(int value, int64_t time_us);
+  void clear();
+
+  uint64_t get_event_count() const { return m_events; }
+
+  LinearityReport analyze(int segments = 8) const;
+
+private:
+  /** Typical time of the non-empty bins around \a bin */
+  uint32_t local_median(int bin, int first, int last) const;
+};
+
+#endif
+
+/* EOF */
@@ -0,0 +1,241 @@
+/*
+**  jstest-gtk - A graphical joystick tester
+**  Copyright (C) 2025 Raphael Rosch <jstest-bugs@insaner.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <sstream>
+#include <glibmm/main.h>
+#include <gtkmm/box.h>
+#include <gtkmm/stock.h>
+
+#include "linearity_dialog.hpp"
+
+LinearityDialog::LinearityDialog(Joystick& joystick_) :
+  Gtk::Dialog("Linearity: " + joystick_.get_name()),
+  joystick(joystick_),
+  orig_data(joystick.get_calibration()),
+  label("Pick an axis and sweep it slowly and evenly from one end to the other, "
+        "a few times back and forth. The curve shows the raw value over the travel, "
+        "a straight diagonal is a linear axis. Red marks raw values that never showed up, "
+        "orange values it got stuck on."),
+  axis_combo(),
+  reset_button("Reset"),
+  curve(),
+  result(),
+  use_button(),
+  connection(),
+  update_timeout(),
+  axis(0),
+  analyzer(),
+  report(analyzer.analyze())
+{
+  // the analysis needs the raw values
+  joystick.clear_calibration();
+
+  set_border_width(5);
+  label.set_line_wrap();
+  result.set_line_wrap();
+  result.set_xalign(0.0);
+  curve.set_size_request(300, 300);
+
+  for(int i = 0; i < joystick.get_axis_count(); ++i)
+  {
+    std::ostringstream str;
+    str << "Axis " << i;
+    axis_combo.append(str.str());
+  }
+  axis_combo.set_active(0);
+
+  Gtk::HBox& axis_box = *Gtk::manage(new Gtk::HBox());
+  axis_box.set_spacing(5);
+  axis_box.pack_start(axis_combo, Gtk::PACK_EXPAND_WIDGET);
+  axis_box.pack_start(reset_button, Gtk::PACK_SHRINK);
+
+  get_vbox()->set_spacing(5);
+  get_vbox()->pack_start(label, Gtk::PACK_SHRINK);
+  get_vbox()->pack_start(axis_box, Gtk::PACK_SHRINK);
+  get_vbox()->pack_start(curve, Gtk::PACK_EXPAND_WIDGET);
+  get_vbox()->pack_start(result, Gtk::PACK_SHRINK);
+
+  add_button(Gtk::Stock::CANCEL, 1);
+  use_button = add_button("Use as Calibration", 0);
+  use_button->set_tooltip_text("Calibrate the axis with the measured ends and center, "
+                               "the rest of the curve can't be expressed in a joydev calibration");
+
+  axis_combo.signal_changed().connect(sigc::mem_fun(this, &LinearityDialog::on_axis_changed));
+  reset_button.signal_clicked().connect(sigc::mem_fun(this, &LinearityDialog::on_reset));
+  curve.signal_draw().connect(sigc::mem_fun(this, &LinearityDialog::on_draw_curve));
+
+  connection = joystick.axis_move.connect(sigc::mem_fun(this, &LinearityDialog::on_axis_move));
+  update_timeout = Glib::signal_timeout().connect(sigc::mem_fun(this, &LinearityDialog::on_update), 200);
+
+  on_update();
+}
+
+LinearityDialog::~LinearityDialog()
+{
+  connection.disconnect();
+  update_timeout.disconnect();
+}
+
+void
+LinearityDialog::on_axis_move(int number, int value)
+{
+  if (number == axis)
+  {
+    analyzer.add(value, g_get_monotonic_time());
+  }
+}
+
+void
+LinearityDialog::on_axis_changed()
+{
+  axis = axis_combo.get_active_row_number();
+  on_reset();
+}
+
+void
+LinearityDialog::on_reset()
+{
+  analyzer.clear();
+  analyzer.add(joystick.get_axis_state(axis), g_get_monotonic_time());
+  on_update();
+}
+
+bool
+LinearityDialog::on_update()
+{
+  report = analyzer.analyze();
+
+  std::ostringstream str;
+  if (report.breakpoints.empty())
+  {
+    str << "Waiting for the axis to move...";
+  }
+  else
+  {
+    str << report.events << " events, raw " << report.calibration.range_min << " to " << report.calibration.range_max;
+    if (report.bin_width > 1)
+      str << " in steps of " << report.bin_width;
+    str << "\nLargest deviation from a straight line: "
+        << static_cast<int>(report.max_error * 1000) / 10.0 << "% of the travel";
+
+    auto print_ranges = [&str](const char* what, const std::vector<std::pair<int, int> >& ranges) {
+      if (ranges.empty())
+        return;
+      str << "\n" << what << ":";
+      for(size_t i = 0; i < ranges.size() && i < 8; ++i)
+      {
+        str << " " << ranges[i].first;
+        if (ranges[i].second != ranges[i].first)
+          str << "-" << ranges[i].second;
+      }
+      if (ranges.size() > 8)
+        str << " and " << ranges.size() - 8 << " more";
+    };
+    print_ranges("Never reported", report.gaps);
+    print_ranges("Stuck on", report.sticky);
+
+    str << "\nConfidence: " << static_cast<int>(report.calibration.confidence * 100) << "%";
+    if (!report.calibration.problem.empty())
+      str << " (" << report.calibration.problem << ")";
+  }
+  result.set_text(str.str());
+  use_button->set_sensitive(!report.breakpoints.empty());
+
+  curve.queue_draw();
+  return true;
+}
+
+bool
+LinearityDialog::on_draw_curve(const ::Cairo::RefPtr< ::Cairo::Context>& cr)
+{
+  int w = curve.get_allocation().get_width() - 10;
+  int h = curve.get_allocation().get_height() - 10;
+
+  cr->translate(5, 5);
+
+  cr->set_source_rgb(0.0, 0.0, 0.0);
+  cr->set_line_width(1.0);
+  cr->rectangle(0, 0, w, h);
+  cr->stroke();
+
+  if (report.breakpoints.size() < 2)
+    return true;
+
+  // travel from left to right, raw value from bottom to top
+  const double lo = report.breakpoints.front();
+  const double hi = report.breakpoints.back();
+  auto raw_y = [&](double raw) { return h - (raw - lo) / std::max(hi - lo, 1.0) * h; };
+
+  cr->set_source_rgb(0.7, 0.7, 0.7);
+  cr->move_to(0, h);
+  cr->line_to(w, 0);
+  cr->stroke();
+
+  cr->set_source_rgb(1.0, 0.0, 0.0);
+  for(const auto& gap : report.gaps)
+  {
+    cr->rectangle(0, raw_y(gap.second + 1), 6, std::max(1.0, raw_y(gap.first) - raw_y(gap.second + 1)));
+  }
+  cr->fill();
+
+  cr->set_source_rgb(1.0, 0.6, 0.0);
+  for(const auto& sticky : report.sticky)
+  {
+    cr->rectangle(w - 6, raw_y(sticky.second + 1), 6, std::max(1.0, raw_y(sticky.first) - raw_y(sticky.second + 1)));
+  }
+  cr->fill();
+
+  cr->set_source_rgb(0.0, 0.0, 0.0);
+  cr->set_line_width(2.0);
+  const int segments = static_cast<int>(report.breakpoints.size()) - 1;
+  for(int i = 0; i <= segments; ++i)
+  {
+    double x = static_cast<double>(i) / segments * w;
+    if (i == 0)
+      cr->move_to(x, raw_y(report.breakpoints[i]));
+    else
+      cr->line_to(x, raw_y(report.breakpoints[i]));
+  }
+  cr->stroke();
+
+  return true;
+}
+
+void
+LinearityDialog::on_response(int v)
+{
+  std::vector<Joystick::CalibrationData> data = orig_data;
+
+  if (v == 0 && axis < static_cast<int>(data.size()))
+  {
+    const AxisCalibrationEstimate& estimate = report.calibration;
+    Joystick::CalibrationData& calibration = data[axis];
+    calibration.calibrate  = true;
+    calibration.invert     = false;
+    calibration.center_min = estimate.center_min;
+    calibration.center_max = estimate.center_max;
+    calibration.range_min  = estimate.range_min;
+    calibration.range_max  = estimate.range_max;
+  }
+
+  joystick.set_calibration(data);
+  hide();
+}
+
+/* EOF */
@@ -0,0 +1,73 @@
+/*
+**  jstest-gtk - A graphical joystick tester
+**  Copyright (C) 2025 Raphael Rosch <jstest-bugs@insaner.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HEADER_JSTEST_GTK_LINEARITY_DIALOG_HPP
+#define HEADER_JSTEST_GTK_LINEARITY_DIALOG_HPP
+
+#include <gtkmm/button.h>
+#include <gtkmm/comboboxtext.h>
+#include <gtkmm/dialog.h>
+#include <gtkmm/drawingarea.h>
+#include <gtkmm/label.h>
+
+#include "joystick.hpp"
+#include "linearity_analyzer.hpp"
+
+/** Records the raw response of one axis while the user sweeps it,
+    shows the measured curve with its gaps and sticky spots and can
+    turn it into a calibration */
+class LinearityDialog : public Gtk::Dialog
+{
+private:
+  Joystick& joystick;
+  std::vector<Joystick::CalibrationData> orig_data;
+
+  Gtk::Label label;
+  Gtk::ComboBoxText axis_combo;
+  Gtk::Button reset_button;
+  Gtk::DrawingArea curve;
+  Gtk::Label result;
+  Gtk::Widget* use_button;
+
+  sigc::connection connection;
+  sigc::connection update_timeout;
+
+  int axis;
+  LinearityAnalyzer analyzer;
+  LinearityReport report;
+
+public:
+  LinearityDialog(Joystick& joystick);
+  ~LinearityDialog();
+
+  void on_response(int v) override;
+
+private:
+  void on_axis_move(int number, int value);
+  void on_axis_changed();
+  void on_reset();
+  bool on_update();
+  bool on_draw_curve(const ::Cairo::RefPtr< ::Cairo::Context>& cr);
+
+  LinearityDialog(const LinearityDialog&);
+  LinearityDialog& operator=(const LinearityDialog&);
+};
+
+#endif
+
+/* EOF */
@@ -24,13 +24,20 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 
+#include "device_metadata_cache.hpp"
+#include "config_cache.hpp"
+#include "config_watcher.hpp"
 #include "joystick_config_files.hpp"
 
 #include "joystick_test_widget.hpp"
 #include "joystick_list_widget.hpp"
 #include "joystick_map_widget.hpp"
 #include "joystick_calibration_widget.hpp"
+#include "mapping_capture_dialog.hpp"
+#include "save_profile_dialog.hpp"
 #include "joystick.hpp"
+#include "profile_store.hpp"
+#include "udev_monitor.hpp"
 #include "main.hpp"
 
 Main* Main::current_ = 0;
@@ -40,7 +47,9 @@ JoystickGui::JoystickGui(std::unique_ptr<Joystick> joystick, bool simple_ui, Gtk
   m_joystick(std::move(joystick)),
   m_test_widget(),
   m_mapping_widget(),
-  m_calibration_widget()
+  m_calibration_widget(),
+  m_capture_widget(),
+  m_save_profile_widget()
 {
   m_test_widget = std::unique_ptr<JoystickTestWidget>(new JoystickTestWidget(*this, *m_joystick, simple_ui));
   if (parent) {
@@ -50,6 +59,16 @@ JoystickGui::JoystickGui(std::unique_ptr<Joystick> joystick, bool simple_ui, Gtk
   m_test_widget->show_all();
 }
 
+void
+JoystickGui::reload_config()
+{
+  if (m_joystick->update_config())
+  {
+    m_verbose and std::cout << m_joystick->get_filename() << ": config changed" << std::endl;
+    m_test_widget->apply_config();
+  }
+}
+
 void
 JoystickGui::show_calibration_dialog()
 {
@@ -59,8 +78,14 @@ JoystickGui::show_calibration_dialog()
   }
   else
   {
+    // other programs like jscal may have changed it in the meantime
+    m_joystick->refresh_calibration();
     m_calibration_widget.reset(new JoystickCalibrationWidget(*m_joystick));
-    m_calibration_widget->signal_hide().connect([this] { m_calibration_widget.reset(); });
+    m_calibration_widget->signal_hide().connect([this] {
+        m_calibration_widget.reset();
+        // the axes report different values now
+        m_test_widget->reset_drift_monitor();
+      });
     m_calibration_widget->set_transient_for(*m_test_widget);
     m_calibration_widget->show_all();
   }
@@ -75,18 +100,56 @@ JoystickGui::show_mapping_dialog()
   }
   else
   {
+    // the remap works from the cached axis map and calibration
+    m_joystick->refresh_calibration();
     m_mapping_widget.reset(new JoystickMapWidget(*m_joystick));
-    m_mapping_widget->signal_hide().connect([this] { m_calibration_widget.reset(); });
+    m_mapping_widget->signal_hide().connect([this] { m_mapping_widget.reset(); });
     m_mapping_widget->set_transient_for(*m_test_widget);
     m_mapping_widget->show_all();
   }
 }
 
+void
+JoystickGui::show_capture_dialog()
+{
+  if (m_capture_widget)
+  {
+    m_capture_widget->present();
+  }
+  else
+  {
+    m_capture_widget.reset(new MappingCaptureDialog(*m_joystick));
+    m_capture_widget->signal_hide().connect([this] { m_capture_widget.reset(); });
+    m_capture_widget->set_transient_for(*m_test_widget);
+    m_capture_widget->show_all();
+  }
+}
+
+void
+JoystickGui::show_save_profile_dialog()
+{
+  if (m_save_profile_widget)
+  {
+    m_save_profile_widget->present();
+  }
+  else
+  {
+    m_save_profile_widget.reset(new SaveProfileDialog(*m_joystick));
+    m_save_profile_widget->signal_hide().connect([this] { m_save_profile_widget.reset(); });
+    m_save_profile_widget->set_transient_for(*m_test_widget);
+    m_save_profile_widget->show_all();
+  }
+}
+
 
 Main::Main() :
   Gtk::Application("com.gmail.grumbel.jstest-gtk", Gio::APPLICATION_HANDLES_OPEN),
   datadir("data/"),
-  m_simple_ui(false)
+  m_config_path(),
+  m_simple_ui(false),
+  m_udev_monitor(),
+  m_config_watcher(),
+  m_profile_store()
 {
   current_ = this;
 }
@@ -112,20 +175,127 @@ Main::show_device_property_dialog(const std::string& filename, Gtk::Window* pare
     std::unique_ptr<JoystickGui> gui(new JoystickGui(std::move(joystick), m_simple_ui, parent));
 
     JoystickTestWidget* widget = gui->get_test_widget();
+    JoystickGui* gui_ptr = gui.get();
     m_joystick_guis[filename] = std::move(gui);
-    widget->signal_hide().connect([this, filename]{
-        m_joystick_guis.erase(filename);
+    // the device file can change on reconnect, so look the gui up
+    // instead of capturing the filename
+    widget->signal_hide().connect([this, gui_ptr]{
+        for(auto it = m_joystick_guis.begin(); it != m_joystick_guis.end(); ++it)
+        {
+          if (it->second.get() == gui_ptr)
+          {
+            m_joystick_guis.erase(it);
+            break;
+          }
+        }
       });
 
     return widget;
   }
 }
 
+void
+Main::on_device_renamed(const std::string& old_filename, const std::string& new_filename)
+{
+  auto it = m_joystick_guis.find(old_filename);
+  if (it != m_joystick_guis.end() &&
+      m_joystick_guis.find(new_filename) == m_joystick_guis.end())
+  {
+    std::unique_ptr<JoystickGui> gui = std::move(it->second);
+    m_joystick_guis.erase(it);
+    m_joystick_guis[new_filename] = std::move(gui);
+  }
+}
+
+void
+Main::on_configs_changed(const std::vector<std::string>& filenames)
+{
+  for(const auto& filename : filenames)
+  {
+    m_verbose and std::cout << "config changed: " << filename << std::endl;
+  }
+
+  reload_configs(filenames);
+}
+
+void
+Main::on_joystick_event(const std::string& action, const std::string& devnode, const std::string& stable_id)
+{
+  if (action != "add" || stable_id.empty())
+    return;
+
+  // connected before any window, so the profile is in place before
+  // a reconnecting Joystick reads the calibration back
+  const JoystickProfile* profile = m_profile_store->find(stable_id);
+  if (profile)
+  {
+    try
+    {
+      apply_profile(devnode, *profile);
+      m_verbose and std::cout << devnode << ": applied profile '" << profile->name << "'" << std::endl;
+    }
+    catch(std::exception& err)
+    {
+      std::cout << "Warning: " << err.what() << std::endl;
+    }
+  }
+}
+
+int
+Main::load_profile_command(const std::string& filename, const std::vector<std::string>& device_files)
+{
+  try
+  {
+    JoystickProfile profile = load_profile(filename);
+
+    if (!device_files.empty())
+    {
+      apply_profile(device_files.front(), profile);
+      std::cout << device_files.front() << ": applied profile '" << profile.name << "'" << std::endl;
+      return 0;
+    }
+
+    // without a device, apply it to the device it was saved for
+    for(const auto& devnode : Joystick::get_joystick_filenames())
+    {
+      if (Joystick::lookup_stable_id(devnode, get_js_dev_id_from_filename(devnode)) == profile.stable_id)
+      {
+        apply_profile(devnode, profile);
+        std::cout << devnode << ": applied profile '" << profile.name << "'" << std::endl;
+        return 0;
+      }
+    }
+
+    std::cout << "Error: " << filename << ": device " << profile.stable_id << " not connected" << std::endl;
+    return EXIT_FAILURE;
+  }
+  catch(std::exception& err)
+  {
+    std::cout << "Error: " << err.what() << std::endl;
+    return EXIT_FAILURE;
+  }
+}
+
+void
+Main::reload_configs(const std::vector<std::string>& changed)
+{
+  // unchanged files come from the config index cache and keep the
+  // config already parsed for them
+  set_joystick_configs(load_config_registry(m_config_path, get_joystick_configs().get(), changed));
+  DeviceMetadataCache::instance().update_configs();
+
+  for(auto& it : m_joystick_guis)
+  {
+    it.second->reload_config();
+  }
+}
+
 int
 Main::run(int argc, char** argv)
 {
   typedef std::vector<std::string> DeviceFiles;
   DeviceFiles device_files;
+  std::string profile_file;
 
   for(int i = 1; i < argc; ++i)
   {
@@ -141,6 +311,9 @@ Main::run(int argc, char** argv)
                 << "  --simple        Hide graphical representation of axis\n"
                 << "  --verbose       Print useful extra information\n"
                 << "  --datadir DIR   Load application data from DIR\n"
+                << "  --load-profile FILE\n"
+                << "                  Apply a saved profile to DEVICE, or to the device it\n"
+                << "                  was saved for, and exit\n"
                 << "\n"
                 << "Report bugs to Ingo Ruhnke <grumbel@gmail.com>.\n";
       return 0;
@@ -172,6 +345,19 @@ Main::run(int argc, char** argv)
         datadir = argv[i];
       }
     }
+    else if (strcmp("--load-profile", argv[i]) == 0)
+    {
+      i += 1;
+      if (i >= argc)
+      {
+        std::cout << "Error: " << argv[0] << ": argument to --load-profile is missing" << std::endl;
+        return EXIT_FAILURE;
+      }
+      else
+      {
+        profile_file = argv[i];
+      }
+    }
     else if (argv[i][0] == '-')
     {
       std::cout << "Error: " << argv[0] << ": unrecognized option '" << argv[i] << "'" << std::endl;
@@ -188,9 +374,69 @@ Main::run(int argc, char** argv)
       device_files.push_back(argv[i]);
     }
   }
-  
+
+  if (!profile_file.empty())
+  {
+    return load_profile_command(profile_file, device_files);
+  }
+
+  m_profile_store.reset(new ProfileStore(get_profile_directory()));
+  m_profile_store->load();
+
+  try
+  {
+    m_udev_monitor.reset(new UdevMonitor());
+    m_udev_monitor->signal_joystick_event.connect(sigc::mem_fun(this, &Main::on_joystick_event));
+    // cached device metadata is only valid as long as we see the
+    // events that invalidate it
+    m_udev_monitor->signal_uevent.connect(sigc::mem_fun(DeviceMetadataCache::instance(),
+                                                        &DeviceMetadataCache::on_uevent));
+    DeviceMetadataCache::instance().enable();
+  }
+  catch(std::exception& err)
+  {
+    std::cout << "Warning: hotplug detection disabled: " << err.what() << std::endl;
+  }
+
   // LOAD CONFIG FILES HERE
-  joystick_configs = load_all_configs("data");
+  m_config_path = get_config_search_path(datadir);
+  set_joystick_configs(load_config_registry(m_config_path));
+
+  try
+  {
+    m_config_watcher.reset(new ConfigWatcher());
+    m_config_watcher->signal_changed.connect(sigc::mem_fun(this, &Main::on_configs_changed));
+
+    // the user's config directory is the last one, create it so configs
+    // written there later, e.g. by the mapping capture, get picked up
+    if (!m_config_path.empty() && !make_directories(m_config_path.back()))
+    {
+      std::cout << "Warning: " << m_config_path.back() << ": " << strerror(errno) << std::endl;
+    }
+
+    for(const auto& directory : m_config_path)
+    {
+      struct stat st;
+      if (stat(directory.c_str(), &st) != 0)
+      {
+        m_verbose and std::cout << "not watching missing config directory: " << directory << std::endl;
+        continue;
+      }
+
+      try
+      {
+        m_config_watcher->add_directory(directory);
+      }
+      catch(std::exception& err)
+      {
+        std::cout << "Warning: changes won't be reloaded: " << err.what() << std::endl;
+      }
+    }
+  }
+  catch(std::exception& err)
+  {
+    std::cout << "Warning: config reloading disabled: " << err.what() << std::endl;
+  }
 
   try
   {
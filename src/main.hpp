@@ -23,13 +23,18 @@
 #include <gtkmm.h>
 #include <map>
 
-extern bool m_verbose;
+#include "verbose.hpp"
 
 class Joystick;
 class JoystickListWidget;
 class JoystickTestWidget;
 class JoystickMapWidget;
 class JoystickCalibrationWidget;
+class MappingCaptureDialog;
+class SaveProfileDialog;
+class UdevMonitor;
+class ConfigWatcher;
+class ProfileStore;
 
 class JoystickGui
 {
@@ -38,6 +43,8 @@ private:
   std::unique_ptr<JoystickTestWidget> m_test_widget;
   std::unique_ptr<JoystickMapWidget> m_mapping_widget;
   std::unique_ptr<JoystickCalibrationWidget> m_calibration_widget;
+  std::unique_ptr<MappingCaptureDialog> m_capture_widget;
+  std::unique_ptr<SaveProfileDialog> m_save_profile_widget;
 
 public:
   JoystickGui(std::unique_ptr<Joystick> joystick,
@@ -46,8 +53,14 @@ public:
 
   JoystickTestWidget* get_test_widget() const { return m_test_widget.get(); }
 
+  /** Picks up a reloaded config for the joystick and rebuilds the
+      labels and layout of the test window when it changed */
+  void reload_config();
+
   void show_calibration_dialog();
   void show_mapping_dialog();
+  void show_capture_dialog();
+  void show_save_profile_dialog();
 };
 
 
@@ -60,8 +73,13 @@ public:
 
 private:
   std::string datadir;
+  std::vector<std::string> m_config_path;
   bool m_simple_ui;
 
+  std::unique_ptr<UdevMonitor> m_udev_monitor;
+  std::unique_ptr<ConfigWatcher> m_config_watcher;
+  std::unique_ptr<ProfileStore> m_profile_store;
+
   std::map<std::string, std::unique_ptr<JoystickGui> > m_joystick_guis;
 
 public:
@@ -70,11 +88,32 @@ public:
 
   JoystickTestWidget* show_device_property_dialog(const std::string& filename, Gtk::Window* parent = nullptr);
 
+  /** Called when an open joystick got rebound to a new device file
+      after a reconnect */
+  void on_device_renamed(const std::string& old_filename, const std::string& new_filename);
+
   static Glib::RefPtr<Main> create();
 
   int run(int argc, char** argv) /* override only since gtkmm 3.4 ! */;
 
   std::string get_data_directory() const { return datadir; }
+
+  /** The udev monitor shared by all windows, nullptr when udev
+      couldn't be set up */
+  UdevMonitor* get_udev_monitor() const { return m_udev_monitor.get(); }
+
+  /** Reloads the configs from the search path and hands them to all
+      open joysticks. The files in \a changed are parsed again, the
+      others keep their config unless their mtime or size changed. */
+  void reload_configs(const std::vector<std::string>& changed = std::vector<std::string>());
+
+  /** Saved calibration and mapping profiles, keyed by stable id */
+  ProfileStore& get_profile_store() const { return *m_profile_store; }
+
+private:
+  void on_configs_changed(const std::vector<std::string>& filenames);
+  void on_joystick_event(const std::string& action, const std::string& devnode, const std::string& stable_id);
+  int load_profile_command(const std::string& filename, const std::vector<std::string>& device_files);
 };
 
 #endif
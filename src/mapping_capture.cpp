@@ -0,0 +1,280 @@
+/*
+**  jstest-gtk - A graphical joystick tester
+**  Copyright (C) 2025 Raphael Rosch <jstest-bugs@insaner.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <map>
+#include <sstream>
+#include <stdlib.h>
+
+#include "mapping_capture.hpp"
+
+MappingCapture::MappingCapture(const std::vector<Control>& controls,
+                               const std::vector<int>& axis_rest, int button_count,
+                               int threshold, int debounce_ms) :
+  m_controls(controls),
+  m_bindings(),
+  m_axis_rest(axis_rest),
+  m_button_count(button_count),
+  m_threshold(threshold),
+  m_debounce_ms(debounce_ms),
+  m_has_candidate(false),
+  m_candidate(),
+  m_candidate_since(0),
+  m_quiet_until(0)
+{
+}
+
+std::vector<MappingCapture::Control>
+MappingCapture::get_gamepad_controls()
+{
+  std::vector<Control> controls = {
+    { "Left X",      "", "Move the left stick left and right",   false },
+    { "Left Y",      "", "Move the left stick up and down",      false },
+    { "Right X",     "", "Move the right stick left and right",  false },
+    { "Right Y",     "", "Move the right stick up and down",     false },
+    { "LT",          "", "Pull the left trigger",                false },
+    { "RT",          "", "Pull the right trigger",               false },
+    { "D-Pad Left",  "D-Pad X", "Press D-Pad left",              true },
+    { "D-Pad Right", "", "Press D-Pad right",                    false },
+    { "D-Pad Up",    "D-Pad Y", "Press D-Pad up",                true },
+    { "D-Pad Down",  "", "Press D-Pad down",                     false },
+    { "A",           "", "Press the bottom face button (A, Cross)",   false },
+    { "B",           "", "Press the right face button (B, Circle)",   false },
+    { "X",           "", "Press the left face button (X, Square)",    false },
+    { "Y",           "", "Press the top face button (Y, Triangle)",   false },
+    { "LB",          "", "Press the left shoulder button",       false },
+    { "RB",          "", "Press the right shoulder button",      false },
+    { "Back",        "", "Press Back / Select / Share",          false },
+    { "Start",       "", "Press Start / Options",                false },
+    { "Guide",       "", "Press the Guide / Home / PS button",   false },
+    { "LS",          "", "Press the left stick in",              false },
+    { "RS",          "", "Press the right stick in",             false },
+  };
+  return controls;
+}
+
+bool
+MappingCapture::is_bound(bool is_axis, int number) const
+{
+  for(const auto& binding : m_bindings)
+  {
+    if (binding.is_axis == is_axis && binding.number == number)
+      return true;
+  }
+  return false;
+}
+
+void
+MappingCapture::bind(const Binding& binding, int64_t time_ms)
+{
+  bool covers_next = binding.is_axis && get_current().axis_covers_next;
+
+  m_bindings.push_back(binding);
+  if (covers_next && !is_done())
+  {
+    m_bindings.push_back(Binding{true, -1});
+  }
+
+  // swallow whatever bounces after the release
+  m_has_candidate = false;
+  m_quiet_until = time_ms + m_debounce_ms;
+}
+
+bool
+MappingCapture::axis_move(int number, int value, int64_t time_ms)
+{
+  if (is_done() || time_ms < m_quiet_until ||
+      number < 0 || number >= static_cast<int>(m_axis_rest.size()) ||
+      is_bound(true, number))
+  {
+    return false;
+  }
+
+  int deflection = abs(value - m_axis_rest[number]);
+
+  if (!m_has_candidate)
+  {
+    if (deflection > m_threshold)
+    {
+      m_has_candidate = true;
+      m_candidate = Binding{true, number};
+      m_candidate_since = time_ms;
+    }
+  }
+  else if (m_candidate.is_axis && m_candidate.number == number &&
+           deflection < m_threshold / 2) // hysteresis, so noise at the threshold doesn't count as release
+  {
+    if (time_ms - m_candidate_since >= m_debounce_ms)
+    {
+      bind(m_candidate, time_ms);
+      return true;
+    }
+    m_has_candidate = false; // spike
+  }
+
+  return false;
+}
+
+bool
+MappingCapture::button_move(int number, bool value, int64_t time_ms)
+{
+  if (is_done() || time_ms < m_quiet_until ||
+      number < 0 || number >= m_button_count ||
+      is_bound(false, number))
+  {
+    return false;
+  }
+
+  if (!m_has_candidate)
+  {
+    if (value)
+    {
+      m_has_candidate = true;
+      m_candidate = Binding{false, number};
+      m_candidate_since = time_ms;
+    }
+  }
+  else if (!m_candidate.is_axis && m_candidate.number == number && !value)
+  {
+    if (time_ms - m_candidate_since >= m_debounce_ms)
+    {
+      bind(m_candidate, time_ms);
+      return true;
+    }
+    m_has_candidate = false; // bounce
+  }
+
+  return false;
+}
+
+void
+MappingCapture::skip()
+{
+  if (!is_done())
+  {
+    m_bindings.push_back(Binding{false, -1});
+    m_has_candidate = false;
+  }
+}
+
+void
+MappingCapture::back()
+{
+  if (!m_bindings.empty())
+  {
+    m_bindings.pop_back();
+    // don't stop on the automatically skipped half of an axis
+    if (!m_bindings.empty() && m_bindings.back().is_axis && m_bindings.back().number >= 0 &&
+        m_controls[m_bindings.size() - 1].axis_covers_next)
+    {
+      m_bindings.pop_back();
+    }
+    m_has_candidate = false;
+  }
+}
+
+std::string
+MappingCapture::get_config(const std::string& name, const std::string& usb_id,
+                           const std::string& js_type) const
+{
+  std::map<int, std::string> axes;
+  std::map<int, std::string> buttons;
+  for(size_t i = 0; i < m_bindings.size(); ++i)
+  {
+    const Binding& binding = m_bindings[i];
+    const Control& control = m_controls[i];
+    if (binding.number < 0)
+      continue;
+
+    if (binding.is_axis)
+      axes[binding.number] = control.axis_label.empty() ? control.label : control.axis_label;
+    else
+      buttons[binding.number] = control.label;
+  }
+
+  std::ostringstream out;
+  out << "# " << name << "\n"
+      << "# generated by the jstest-gtk mapping capture\n"
+      << "usb_id=" << usb_id << "\n";
+  if (js_type.empty())
+    out << "# js_type=xbox360 # or ps4-dualshock4, ps3-sixaxis, ps2-dualshock2\n";
+  else
+    out << "js_type=" << js_type << "\n";
+
+  for(const auto& it : axes)
+    out << "axis_" << it.first << "=" << it.second << "\n";
+  for(const auto& it : buttons)
+    out << "button_" << it.first << "=" << it.second << "\n";
+
+  return out.str();
+}
+
+#ifdef __TEST__
+
+// g++ -std=c++11 -O2 -D__TEST__ mapping_capture.cpp -o mapping-capture-test
+
+#include <iostream>
+
+int main(int argc, char** argv)
+{
+  // 8 axes like an Xbox 360 pad, triggers rest at -32767
+  std::vector<int> rest = { 0, 0, -32767, 0, 0, -32767, 0, 0 };
+  MappingCapture capture(MappingCapture::get_gamepad_controls(), rest, 11);
+  int64_t t = 0;
+
+  // left stick x, with a stray spike on axis 1 first that is too short
+  capture.axis_move(1, 20000, t); capture.axis_move(1, 0, t += 10);
+  capture.axis_move(0, 30000, t += 100); capture.axis_move(0, 500, t += 200);
+  // left stick y, moving diagonally touches the already bound x
+  capture.axis_move(0, 20000, t += 100); capture.axis_move(1, -32767, t += 5);
+  capture.axis_move(0, 0, t += 5); capture.axis_move(1, 0, t += 200);
+  // right stick
+  capture.axis_move(3, 32767, t += 100); capture.axis_move(3, 0, t += 200);
+  capture.axis_move(4, 32767, t += 100); capture.axis_move(4, 0, t += 200);
+  // triggers
+  capture.axis_move(2, 32767, t += 100); capture.axis_move(2, -32767, t += 200);
+  capture.axis_move(5, 32767, t += 100); capture.axis_move(5, -32767, t += 200);
+  // d-pad is a hat, left covers right
+  capture.axis_move(6, -32767, t += 100); capture.axis_move(6, 0, t += 200);
+  capture.axis_move(7, -32767, t += 100); capture.axis_move(7, 0, t += 200);
+  // A with contact bounce
+  capture.button_move(0, true, t += 100); capture.button_move(0, false, t += 2);
+  capture.button_move(0, true, t += 2); capture.button_move(0, false, t += 150);
+  capture.button_move(0, true, t += 5); capture.button_move(0, false, t += 5); // bounce after release
+  for (int button = 1; button < 11; ++button) {
+    capture.button_move(button, true, t += 100);
+    capture.button_move(button, false, t += 100);
+  }
+
+  std::string config = capture.get_config("Test Pad", "045e:028e", "xbox360");
+  std::string expected =
+    "# Test Pad\n"
+    "# generated by the jstest-gtk mapping capture\n"
+    "usb_id=045e:028e\n"
+    "js_type=xbox360\n"
+    "axis_0=Left X\naxis_1=Left Y\naxis_2=LT\naxis_3=Right X\naxis_4=Right Y\n"
+    "axis_5=RT\naxis_6=D-Pad X\naxis_7=D-Pad Y\n"
+    "button_0=A\nbutton_1=B\nbutton_2=X\nbutton_3=Y\nbutton_4=LB\nbutton_5=RB\n"
+    "button_6=Back\nbutton_7=Start\nbutton_8=Guide\nbutton_9=LS\nbutton_10=RS\n";
+
+  bool ok = capture.is_done() && config == expected;
+  std::cout << config << (ok ? "ok" : "WRONG") << std::endl;
+  return ok ? 0 : 1;
+}
+#endif
+
+/* EOF */
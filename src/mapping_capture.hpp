@@ -0,0 +1,98 @@
+/*
+**  jstest-gtk - A graphical joystick tester
+**  Copyright (C) 2025 Raphael Rosch <jstest-bugs@insaner.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HEADER_JSTEST_GTK_MAPPING_CAPTURE_HPP
+#define HEADER_JSTEST_GTK_MAPPING_CAPTURE_HPP
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/** Walks through a list of logical controls and binds each to the
+    axis or button the user actuates when prompted. An input counts
+    once it got pressed (or deflected past the threshold) and released
+    again after being held for at least the debounce time, so contact
+    bounce and stick noise never produce a binding. Inputs that are
+    already bound are ignored. */
+class MappingCapture
+{
+public:
+  struct Control
+  {
+    std::string label;      // written to the config, e.g. "LB"
+    std::string axis_label; // label when it turns out to be an axis
+    std::string prompt;
+    // the next control is the other half of the same axis, e.g.
+    // D-Pad Left/Right on a hat, so skip it when this one is an axis
+    bool axis_covers_next;
+  };
+
+  struct Binding
+  {
+    bool is_axis;
+    int number; // -1 when the control was skipped
+  };
+
+private:
+  std::vector<Control> m_controls;
+  std::vector<Binding> m_bindings; // one per control handled so far
+
+  std::vector<int> m_axis_rest;
+  int m_button_count;
+  int m_threshold;
+  int m_debounce_ms;
+
+  bool m_has_candidate;
+  Binding m_candidate;
+  int64_t m_candidate_since;
+  int64_t m_quiet_until; // input is ignored until then after a capture
+
+public:
+  /** \a axis_rest are the axis values while nothing is touched */
+  MappingCapture(const std::vector<Control>& controls,
+                 const std::vector<int>& axis_rest, int button_count,
+                 int threshold = 16384, int debounce_ms = 50);
+
+  /** Sticks, triggers, d-pad and face buttons of a typical gamepad */
+  static std::vector<Control> get_gamepad_controls();
+
+  /** Feed the live event stream, return true when the current control
+      got bound */
+  bool axis_move(int number, int value, int64_t time_ms);
+  bool button_move(int number, bool value, int64_t time_ms);
+
+  void skip();
+  void back();
+
+  bool is_done() const { return m_bindings.size() >= m_controls.size(); }
+  size_t get_current_index() const { return m_bindings.size(); }
+  size_t get_control_count() const { return m_controls.size(); }
+  const Control& get_current() const { return m_controls[m_bindings.size()]; }
+
+  /** The captured bindings as .config file contents */
+  std::string get_config(const std::string& name, const std::string& usb_id,
+                         const std::string& js_type) const;
+
+private:
+  bool is_bound(bool is_axis, int number) const;
+  void bind(const Binding& binding, int64_t time_ms);
+};
+
+#endif
+
+/* EOF */
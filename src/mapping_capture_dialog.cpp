@@ -0,0 +1,197 @@
+/*
+**  jstest-gtk - A graphical joystick tester
+**  Copyright (C) 2025 Raphael Rosch <jstest-bugs@insaner.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <errno.h>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string.h>
+#include <glib/gstdio.h>
+#include <gtkmm/stock.h>
+
+#include "joystick.hpp"
+#include "joystick_config_files.hpp"
+#include "mapping_capture_dialog.hpp"
+#include "main.hpp"
+
+enum {
+  RESPONSE_CLOSE,
+  RESPONSE_BACK,
+  RESPONSE_SKIP,
+  RESPONSE_SAVE
+};
+
+MappingCaptureDialog::MappingCaptureDialog(Joystick& joystick) :
+  Gtk::Dialog("Capture Mapping: " + joystick.get_name()),
+  m_joystick(joystick),
+  m_capture(MappingCapture::get_gamepad_controls(), get_axis_rest(joystick), joystick.get_button_count()),
+  m_prompt(),
+  m_progress(),
+  m_scroll(),
+  m_preview(),
+  m_save_button(),
+  m_axis_connection(),
+  m_button_connection()
+{
+  set_border_width(5);
+  set_default_size(400, 450);
+
+  m_prompt.set_line_wrap();
+  m_preview.set_editable(false);
+  m_preview.set_monospace(true);
+  m_scroll.set_policy(Gtk::POLICY_AUTOMATIC, Gtk::POLICY_AUTOMATIC);
+  m_scroll.add(m_preview);
+
+  get_vbox()->set_spacing(5);
+  get_vbox()->pack_start(m_prompt, Gtk::PACK_SHRINK);
+  get_vbox()->pack_start(m_progress, Gtk::PACK_SHRINK);
+  get_vbox()->pack_start(m_scroll, Gtk::PACK_EXPAND_WIDGET);
+
+  add_button(Gtk::Stock::GO_BACK, RESPONSE_BACK);
+  add_button("Skip", RESPONSE_SKIP);
+  m_save_button = add_button(Gtk::Stock::SAVE, RESPONSE_SAVE);
+  Gtk::Widget* close_button = add_button(Gtk::Stock::CLOSE, RESPONSE_CLOSE);
+
+  m_axis_connection = joystick.axis_move.connect(sigc::mem_fun(this, &MappingCaptureDialog::on_axis_move));
+  m_button_connection = joystick.button_move.connect(sigc::mem_fun(this, &MappingCaptureDialog::on_button_move));
+
+  signal_response().connect(sigc::mem_fun(this, &MappingCaptureDialog::on_response));
+
+  update();
+  close_button->grab_focus();
+}
+
+MappingCaptureDialog::~MappingCaptureDialog()
+{
+  m_axis_connection.disconnect();
+  m_button_connection.disconnect();
+}
+
+std::vector<int>
+MappingCaptureDialog::get_axis_rest(Joystick& joystick)
+{
+  // whatever the axes read right now is taken as their rest position,
+  // that is how triggers resting at -32767 get handled
+  std::vector<int> rest;
+  for(int i = 0; i < joystick.get_axis_count(); ++i)
+  {
+    rest.push_back(joystick.get_axis_state(i));
+  }
+  return rest;
+}
+
+void
+MappingCaptureDialog::on_axis_move(int number, int value)
+{
+  if (m_capture.axis_move(number, value, g_get_monotonic_time() / 1000))
+    update();
+}
+
+void
+MappingCaptureDialog::on_button_move(int number, bool value)
+{
+  if (m_capture.button_move(number, value, g_get_monotonic_time() / 1000))
+    update();
+}
+
+void
+MappingCaptureDialog::update()
+{
+  if (m_capture.is_done())
+  {
+    m_prompt.set_markup("<big><b>Done</b></big>\nSave the config below to use it.");
+    m_progress.set_text("");
+  }
+  else
+  {
+    m_prompt.set_markup("<big><b>" + Glib::Markup::escape_text(m_capture.get_current().prompt) + "</b></big>\n"
+                        "and let go again, or press Skip when the controller has no such control.");
+    std::ostringstream str;
+    str << "Control " << m_capture.get_current_index() + 1 << " of " << m_capture.get_control_count();
+    m_progress.set_text(str.str());
+  }
+
+  m_preview.get_buffer()->set_text(m_capture.get_config(m_joystick.get_name(),
+                                                        m_joystick.get_usb_id(),
+                                                        m_joystick.get_js_type()));
+  m_save_button->set_sensitive(m_capture.is_done() && !m_joystick.get_usb_id().empty());
+}
+
+void
+MappingCaptureDialog::save()
+{
+  // the last entry of the search path is the user's config directory,
+  // which overrides the shipped configs
+  std::string directory = get_config_search_path(Main::current()->get_data_directory()).back();
+  std::string name = m_joystick.get_usb_id();
+  name[name.find(':')] = '-';
+  std::string filename = directory + "/" + name + ".config";
+
+  std::ostringstream error;
+  if (g_mkdir_with_parents(directory.c_str(), 0755) != 0)
+  {
+    error << directory << ": " << strerror(errno);
+  }
+  else
+  {
+    std::ofstream out(filename);
+    out << m_preview.get_buffer()->get_text();
+    if (!out.flush())
+      error << filename << ": " << strerror(errno);
+  }
+
+  if (!error.str().empty())
+  {
+    std::cout << error.str() << std::endl;
+    m_prompt.set_markup("<span foreground='red'>" + Glib::Markup::escape_text(error.str()) + "</span>");
+  }
+  else
+  {
+    m_verbose and std::cout << "wrote " << filename << std::endl;
+    m_prompt.set_markup("<big><b>Saved</b></big>\n" + Glib::Markup::escape_text(filename));
+    // show it right away instead of waiting for the config watcher
+    Main::current()->reload_configs(std::vector<std::string>(1, filename));
+  }
+}
+
+void
+MappingCaptureDialog::on_response(int v)
+{
+  switch(v)
+  {
+    case RESPONSE_BACK:
+      m_capture.back();
+      update();
+      break;
+
+    case RESPONSE_SKIP:
+      m_capture.skip();
+      update();
+      break;
+
+    case RESPONSE_SAVE:
+      save();
+      break;
+
+    default:
+      hide();
+      break;
+  }
+}
+
+/* EOF */
@@ -0,0 +1,68 @@
+/*
+**  jstest-gtk - A graphical joystick tester
+**  Copyright (C) 2025 Raphael Rosch <jstest-bugs@insaner.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HEADER_JSTEST_GTK_MAPPING_CAPTURE_DIALOG_HPP
+#define HEADER_JSTEST_GTK_MAPPING_CAPTURE_DIALOG_HPP
+
+#include <gtkmm/dialog.h>
+#include <gtkmm/label.h>
+#include <gtkmm/scrolledwindow.h>
+#include <gtkmm/textview.h>
+
+#include "mapping_capture.hpp"
+
+class Joystick;
+
+/** Prompts for one control after the other and writes the result as
+    a .config to the user's config directory */
+class MappingCaptureDialog : public Gtk::Dialog
+{
+private:
+  Joystick& m_joystick;
+  MappingCapture m_capture;
+
+  Gtk::Label m_prompt;
+  Gtk::Label m_progress;
+  Gtk::ScrolledWindow m_scroll;
+  Gtk::TextView m_preview;
+  Gtk::Widget* m_save_button;
+
+  sigc::connection m_axis_connection;
+  sigc::connection m_button_connection;
+
+public:
+  MappingCaptureDialog(Joystick& joystick);
+  ~MappingCaptureDialog();
+
+private:
+  void on_axis_move(int number, int value);
+  void on_button_move(int number, bool value);
+  void on_response(int v);
+
+  void update();
+  void save();
+
+  static std::vector<int> get_axis_rest(Joystick& joystick);
+
+  MappingCaptureDialog(const MappingCaptureDialog&);
+  MappingCaptureDialog& operator=(const MappingCaptureDialog&);
+};
+
+#endif
+
+/* EOF */
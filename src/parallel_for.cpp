@@ -0,0 +1,79 @@
+/*
+**  jstest-gtk - A graphical joystick tester
+**  Copyright (C) 2025 Raphael Rosch <jstest-bugs@insaner.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include "parallel_for.hpp"
+
+int get_io_thread_count()
+{
+  int cores = static_cast<int>(std::thread::hardware_concurrency());
+  return std::min(std::max(2 * cores, 4), 16);
+}
+
+void parallel_for(size_t count, const std::function<void (size_t)>& func, int max_threads)
+{
+  if (max_threads <= 0)
+  {
+    max_threads = get_io_thread_count();
+  }
+
+  size_t thread_count = std::min(count, static_cast<size_t>(max_threads));
+  if (thread_count <= 1)
+  {
+    for(size_t i = 0; i < count; ++i)
+    {
+      func(i);
+    }
+    return;
+  }
+
+  std::atomic<size_t> next(0);
+  auto worker = [&] {
+    for(size_t i = next++; i < count; i = next++)
+    {
+      func(i);
+    }
+  };
+
+  std::vector<std::thread> threads;
+  threads.reserve(thread_count - 1);
+  try
+  {
+    for(size_t i = 1; i < thread_count; ++i)
+    {
+      threads.push_back(std::thread(worker));
+    }
+  }
+  catch(std::system_error& err)
+  {
+    // out of threads, the ones that did start pick up the work
+  }
+  worker();
+
+  for(auto& thread : threads)
+  {
+    thread.join();
+  }
+}
+
+/* EOF */
@@ -0,0 +1,41 @@
+/*
+**  jstest-gtk - A graphical joystick tester
+**  Copyright (C) 2025 Raphael Rosch <jstest-bugs@insaner.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HEADER_JSTEST_GTK_PARALLEL_FOR_HPP
+#define HEADER_JSTEST_GTK_PARALLEL_FOR_HPP
+
+#include <functional>
+#include <stddef.h>
+
+/** Number of threads used for file I/O bound work when none is given:
+    more than there are cores, as most of the time is spent waiting
+    for the disk or a network home directory, but bounded */
+int get_io_thread_count();
+
+/** Calls \a func(i) for every i in [0, count) on up to \a max_threads
+    threads, including the calling one, and returns once all calls
+    finished. Indices are handed out in ascending order, but calls may
+    finish in any order, so \a func should write its result to slot i
+    of a preallocated vector. \a func must not throw. A \a max_threads
+    of 0 uses get_io_thread_count(). */
+void parallel_for(size_t count, const std::function<void (size_t)>& func,
+                  int max_threads = 0);
+
+#endif
+
+/* EOF */
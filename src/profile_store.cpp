@@ -0,0 +1,416 @@
+/*
+**  jstest-gtk - A graphical joystick tester
+**  Copyright (C) 2025 Raphael Rosch <jstest-bugs@insaner.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <linux/input.h>
+#include <sstream>
+#include <stdexcept>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include "config_cache.hpp"
+#include "profile_store.hpp"
+#include "verbose.hpp"
+
+namespace {
+
+std::runtime_error profile_error(const std::string& filename, const std::string& message)
+{
+  return std::runtime_error(filename + ": " + message);
+}
+
+std::vector<int> parse_ints(const std::string& value)
+{
+  std::vector<int> result;
+  std::istringstream in(value);
+  int i;
+  while (in >> i)
+  {
+    result.push_back(i);
+  }
+  return result;
+}
+
+std::string format_ints(const std::vector<int>& values)
+{
+  std::ostringstream out;
+  for(size_t i = 0; i < values.size(); ++i)
+  {
+    out << (i ? " " : "") << values[i];
+  }
+  return out.str();
+}
+
+} // namespace
+
+std::string get_profile_directory()
+{
+  const char* xdg_config_home = getenv("XDG_CONFIG_HOME");
+  if (xdg_config_home && xdg_config_home[0] == '/')
+  {
+    return std::string(xdg_config_home) + "/jstest-gtk/profiles";
+  }
+
+  const char* home = getenv("HOME");
+  if (home && home[0] == '/')
+  {
+    return std::string(home) + "/.config/jstest-gtk/profiles";
+  }
+
+  return std::string();
+}
+
+JoystickProfile load_profile(const std::string& filename)
+{
+  std::ifstream in(filename);
+  if (!in)
+  {
+    throw profile_error(filename, strerror(errno));
+  }
+
+  JoystickProfile profile;
+  std::string line;
+  int line_number = 0;
+  while (std::getline(in, line))
+  {
+    line_number += 1;
+    if (line.empty() || line[0] == '#')
+      continue;
+
+    std::string::size_type eq = line.find('=');
+    if (eq == std::string::npos)
+    {
+      throw profile_error(filename, "line " + std::to_string(line_number) + ": missing '='");
+    }
+
+    std::string key = line.substr(0, eq);
+    std::string value = line.substr(eq + 1);
+
+    if (key == "stable_id")
+    {
+      profile.stable_id = value;
+    }
+    else if (key == "name")
+    {
+      profile.name = value;
+    }
+    else if (key == "axes")
+    {
+      profile.axis_count = atoi(value.c_str());
+    }
+    else if (key == "buttons")
+    {
+      profile.button_count = atoi(value.c_str());
+    }
+    else if (key == "axis_map")
+    {
+      profile.has_mapping = true;
+      profile.axis_mapping = parse_ints(value);
+    }
+    else if (key == "button_map")
+    {
+      profile.has_mapping = true;
+      profile.button_mapping = parse_ints(value);
+    }
+    else if (key.compare(0, 5, "corr_") == 0)
+    {
+      // corr_N=type prec coef0 .. coef7
+      int axis = atoi(key.c_str() + 5);
+      std::vector<int> values = parse_ints(value);
+      if (axis < 0 || axis > ABS_MAX || values.size() != 10)
+      {
+        throw profile_error(filename, "line " + std::to_string(line_number) + ": malformed " + key);
+      }
+
+      if (static_cast<int>(profile.corr.size()) <= axis)
+      {
+        profile.corr.resize(axis + 1);
+      }
+      struct js_corr& corr = profile.corr[axis];
+      corr.type = values[0];
+      corr.prec = values[1];
+      std::copy(values.begin() + 2, values.end(), corr.coef);
+      profile.has_calibration = true;
+    }
+  }
+
+  if (profile.stable_id.empty())
+  {
+    throw profile_error(filename, "stable_id missing");
+  }
+  if ((profile.has_mapping &&
+       (static_cast<int>(profile.axis_mapping.size()) != profile.axis_count ||
+        static_cast<int>(profile.button_mapping.size()) != profile.button_count)) ||
+      (profile.has_calibration && static_cast<int>(profile.corr.size()) != profile.axis_count))
+  {
+    throw profile_error(filename, "mapping or calibration doesn't match the number of axes and buttons");
+  }
+
+  return profile;
+}
+
+void save_profile(const std::string& filename, const JoystickProfile& profile)
+{
+  std::ostringstream out;
+  out << "# jstest-gtk profile\n"
+      << "stable_id=" << profile.stable_id << "\n"
+      << "name=" << profile.name << "\n"
+      << "axes=" << profile.axis_count << "\n"
+      << "buttons=" << profile.button_count << "\n";
+
+  if (profile.has_mapping)
+  {
+    out << "axis_map=" << format_ints(profile.axis_mapping) << "\n"
+        << "button_map=" << format_ints(profile.button_mapping) << "\n";
+  }
+
+  if (profile.has_calibration)
+  {
+    for(size_t i = 0; i < profile.corr.size(); ++i)
+    {
+      const struct js_corr& corr = profile.corr[i];
+      out << "corr_" << i << "=" << corr.type << " " << corr.prec;
+      for(int j = 0; j < 8; ++j)
+      {
+        out << " " << corr.coef[j];
+      }
+      out << "\n";
+    }
+  }
+
+  std::string directory = filename.substr(0, filename.rfind('/'));
+  if (!make_directories(directory))
+  {
+    throw profile_error(directory, strerror(errno));
+  }
+
+  // replace the old profile in one go, it might get read on hotplug
+  // at any time
+  std::string tmp_filename = filename + ".tmp" + std::to_string(getpid());
+  FILE* file = fopen(tmp_filename.c_str(), "w");
+  if (!file)
+  {
+    throw profile_error(tmp_filename, strerror(errno));
+  }
+
+  const std::string& data = out.str();
+  bool ok = fwrite(data.data(), 1, data.size(), file) == data.size();
+  ok = (fclose(file) == 0) && ok;
+
+  if (!ok || rename(tmp_filename.c_str(), filename.c_str()) != 0)
+  {
+    int err = errno;
+    unlink(tmp_filename.c_str());
+    throw profile_error(filename, strerror(err));
+  }
+}
+
+void apply_profile(const std::string& devnode, const JoystickProfile& profile)
+{
+  int fd = open(devnode.c_str(), O_RDONLY | O_NONBLOCK);
+  if (fd < 0)
+  {
+    throw profile_error(devnode, strerror(errno));
+  }
+
+  try
+  {
+    uint8_t axis_count = 0;
+    uint8_t button_count = 0;
+    ioctl(fd, JSIOCGAXES, &axis_count);
+    ioctl(fd, JSIOCGBUTTONS, &button_count);
+    if (axis_count != profile.axis_count || button_count != profile.button_count)
+    {
+      throw profile_error(devnode, "profile '" + profile.name + "' is for a device with a different number of axes or buttons");
+    }
+
+    // the calibration is indexed by the mapped axes, so the mapping
+    // has to go first
+    if (profile.has_mapping)
+    {
+      uint8_t axismap[ABS_MAX + 1];
+      memset(axismap, 0, sizeof(axismap));
+      std::copy(profile.axis_mapping.begin(), profile.axis_mapping.end(), axismap);
+      if (ioctl(fd, JSIOCSAXMAP, axismap) < 0)
+      {
+        throw profile_error(devnode, strerror(errno));
+      }
+
+      uint16_t btnmap[KEY_MAX - BTN_MISC + 1];
+      memset(btnmap, 0, sizeof(btnmap));
+      std::copy(profile.button_mapping.begin(), profile.button_mapping.end(), btnmap);
+      if (ioctl(fd, JSIOCSBTNMAP, btnmap) < 0)
+      {
+        throw profile_error(devnode, strerror(errno));
+      }
+    }
+
+    if (profile.has_calibration)
+    {
+      if (ioctl(fd, JSIOCSCORR, profile.corr.data()) < 0)
+      {
+        throw profile_error(devnode, strerror(errno));
+      }
+    }
+  }
+  catch(...)
+  {
+    close(fd);
+    throw;
+  }
+
+  close(fd);
+}
+
+ProfileStore::ProfileStore(const std::string& directory) :
+  m_directory(directory),
+  m_profiles()
+{
+}
+
+void
+ProfileStore::load()
+{
+  m_profiles.clear();
+
+  DIR* dir = opendir(m_directory.c_str());
+  if (!dir)
+  {
+    // no profiles saved yet
+    m_verbose and std::cout << m_directory << ": " << strerror(errno) << std::endl;
+    return;
+  }
+
+  while (struct dirent* entry = readdir(dir))
+  {
+    std::string name = entry->d_name;
+    if (name.size() > 8 && name.compare(name.size() - 8, 8, ".profile") == 0)
+    {
+      try
+      {
+        JoystickProfile profile = load_profile(m_directory + "/" + name);
+        m_profiles[profile.stable_id] = profile;
+      }
+      catch(const std::exception& err)
+      {
+        std::cout << "Warning: " << err.what() << std::endl;
+      }
+    }
+  }
+  closedir(dir);
+
+  m_verbose and std::cout << m_directory << ": " << m_profiles.size() << " profiles" << std::endl;
+}
+
+const JoystickProfile*
+ProfileStore::find(const std::string& stable_id) const
+{
+  auto it = m_profiles.find(stable_id);
+  if (it == m_profiles.end())
+    return nullptr;
+  else
+    return &it->second;
+}
+
+std::string
+ProfileStore::get_filename(const std::string& stable_id) const
+{
+  // stable ids are serials or udev paths like
+  // "pci-0000:00:14.0-usb-0:2:1.0", keep them readable but safe
+  std::string name = stable_id;
+  for(auto& c : name)
+  {
+    if (!isalnum(static_cast<unsigned char>(c)) && c != '-' && c != '_' && c != '.')
+      c = '_';
+  }
+  return m_directory + "/" + name + ".profile";
+}
+
+void
+ProfileStore::save(const JoystickProfile& profile)
+{
+  save_profile(get_filename(profile.stable_id), profile);
+  m_profiles[profile.stable_id] = profile;
+}
+
+#ifdef __TEST__
+
+// g++ -std=c++11 -O2 -D__TEST__ profile_store.cpp config_cache.o joystick_config_files.o sdl_mapping.o parallel_for.o -o profile-store-test -pthread
+
+bool m_verbose = false;
+
+int main(int argc, char** argv)
+{
+  char dir_template[] = "/tmp/jstest-gtk-profiles-XXXXXX";
+  std::string tmpdir = mkdtemp(dir_template);
+
+  JoystickProfile profile;
+  profile.stable_id = "pci-0000:00:14.0-usb-0:2:1.0";
+  profile.name = "Test Pad";
+  profile.axis_count = 3;
+  profile.button_count = 2;
+  profile.has_mapping = true;
+  profile.axis_mapping = { ABS_Y, ABS_X, ABS_Z };
+  profile.button_mapping = { BTN_B, BTN_A };
+  profile.has_calibration = true;
+  profile.corr.resize(3);
+  for(int i = 0; i < 3; ++i)
+  {
+    memset(&profile.corr[i], 0, sizeof(struct js_corr));
+    profile.corr[i].type = JS_CORR_BROKEN;
+    profile.corr[i].coef[0] = -100 * i;
+    profile.corr[i].coef[1] = 100 * i;
+    profile.corr[i].coef[2] = 536854528 / (32767 - i);
+    profile.corr[i].coef[3] = -536854528 / (32767 - i);
+  }
+
+  ProfileStore store(tmpdir + "/profiles");
+  store.save(profile);
+
+  ProfileStore reloaded(tmpdir + "/profiles");
+  reloaded.load();
+  const JoystickProfile* loaded = reloaded.find(profile.stable_id);
+
+  bool ok = loaded && loaded->name == profile.name &&
+    loaded->axis_mapping == profile.axis_mapping &&
+    loaded->button_mapping == profile.button_mapping &&
+    loaded->corr.size() == profile.corr.size() &&
+    memcmp(loaded->corr.data(), profile.corr.data(), profile.corr.size() * sizeof(struct js_corr)) == 0 &&
+    !reloaded.find("other");
+
+  std::cout << store.get_filename(profile.stable_id) << std::endl;
+  std::cout << (ok ? "ok" : "WRONG") << std::endl;
+
+  unlink(store.get_filename(profile.stable_id).c_str());
+  rmdir((tmpdir + "/profiles").c_str());
+  rmdir(tmpdir.c_str());
+  return ok ? 0 : 1;
+}
+
+#endif
+
+/* EOF */
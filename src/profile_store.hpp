@@ -0,0 +1,97 @@
+/*
+**  jstest-gtk - A graphical joystick tester
+**  Copyright (C) 2025 Raphael Rosch <jstest-bugs@insaner.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HEADER_JSTEST_GTK_PROFILE_STORE_HPP
+#define HEADER_JSTEST_GTK_PROFILE_STORE_HPP
+
+#include <linux/joystick.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/** Calibration and mapping saved for one physical device */
+struct JoystickProfile
+{
+  std::string stable_id;
+  std::string name;
+  int axis_count;
+  int button_count;
+
+  bool has_calibration;
+  std::vector<struct js_corr> corr;
+
+  bool has_mapping;
+  std::vector<int> axis_mapping;
+  std::vector<int> button_mapping;
+
+  JoystickProfile() :
+    stable_id(), name(), axis_count(0), button_count(0),
+    has_calibration(false), corr(),
+    has_mapping(false), axis_mapping(), button_mapping()
+  {}
+};
+
+/** Directory profiles are stored in, $XDG_CONFIG_HOME/jstest-gtk/profiles/
+    or ~/.config/jstest-gtk/profiles/ */
+std::string get_profile_directory();
+
+/** Reads and writes the key=value profile format, both throw
+    std::runtime_error with the filename on errors */
+JoystickProfile load_profile(const std::string& filename);
+void save_profile(const std::string& filename, const JoystickProfile& profile);
+
+/** Writes the mapping and calibration of \a profile to the joydev
+    \a devnode directly, without setting up a Joystick, so it can run
+    right when the device shows up. Throws when the device can't be
+    opened or has a different number of axes or buttons. */
+void apply_profile(const std::string& devnode, const JoystickProfile& profile);
+
+/** The profiles of a directory, one file per device, keyed by the
+    stable id. Everything is read up front so that a hotplug event only
+    costs a hash lookup. */
+class ProfileStore
+{
+private:
+  std::string m_directory;
+  std::unordered_map<std::string, JoystickProfile> m_profiles;
+
+public:
+  explicit ProfileStore(const std::string& directory);
+
+  /** Reads all *.profile files of the directory, files that fail to
+      load are reported and skipped */
+  void load();
+
+  /** nullptr when there is no profile for \a stable_id */
+  const JoystickProfile* find(const std::string& stable_id) const;
+
+  /** Writes \a profile to the directory and adds it to the store,
+      replacing an older profile of the same device. Throws on
+      errors. */
+  void save(const JoystickProfile& profile);
+
+  std::string get_filename(const std::string& stable_id) const;
+
+private:
+  ProfileStore(const ProfileStore&);
+  ProfileStore& operator=(const ProfileStore&);
+};
+
+#endif
+
+/* EOF */
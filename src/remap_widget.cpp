@@ -122,21 +122,25 @@ void
 RemapWidget::on_apply()
 {
   std::vector<int> mapping;
-  std::vector<int> mapping_old;
   for(Gtk::TreeIter i = map_list->children().begin(); i != map_list->children().end(); ++i)
   {
     mapping.push_back((*i)[RemapWidgetColumns::instance().id]);
   }
 
-  if (mode == REMAP_AXIS)
+  try
   {
-    mapping_old = joystick.get_axis_mapping();
-    joystick.set_axis_mapping(mapping);
-    joystick.correct_calibration(mapping_old, mapping);
+    if (mode == REMAP_AXIS)
+    {
+      joystick.remap_axes(mapping);
+    }
+    else if (mode == REMAP_BUTTON)
+    {
+      joystick.set_button_mapping(mapping);
+    }
   }
-  else if (mode == REMAP_BUTTON)
+  catch(std::exception& err)
   {
-    joystick.set_button_mapping(mapping);
+    std::cout << err.what() << std::endl;
   }
 }
 
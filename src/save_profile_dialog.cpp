@@ -0,0 +1,129 @@
+/*
+**  jstest-gtk - A graphical joystick tester
+**  Copyright (C) 2025 Raphael Rosch <jstest-bugs@insaner.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <iostream>
+#include <gtkmm/stock.h>
+
+#include "joystick.hpp"
+#include "main.hpp"
+#include "profile_store.hpp"
+#include "save_profile_dialog.hpp"
+
+SaveProfileDialog::SaveProfileDialog(Joystick& joystick) :
+  Gtk::Dialog("Save Profile: " + joystick.get_name()),
+  m_joystick(joystick),
+  m_label("The profile is applied automatically whenever this device is plugged in "
+          "while jstest-gtk is running, or with 'jstest-gtk --load-profile FILE'."),
+  m_name(),
+  m_save_calibration("Save calibration"),
+  m_save_mapping("Save mapping"),
+  m_status()
+{
+  set_border_width(5);
+  m_label.set_line_wrap();
+  m_status.set_line_wrap();
+
+  const JoystickProfile* old_profile = Main::current()->get_profile_store().find(joystick.get_stable_id());
+  m_name.set_text(old_profile ? old_profile->name : std::string(joystick.get_name()));
+  m_save_calibration.set_active(!old_profile || old_profile->has_calibration);
+  m_save_mapping.set_active(!old_profile || old_profile->has_mapping);
+
+  if (joystick.get_stable_id().empty())
+  {
+    m_status.set_markup("<span foreground='red'>udev doesn't know a serial number or port for this device, "
+                        "so it can't be recognized again</span>");
+  }
+  else if (old_profile)
+  {
+    m_status.set_markup("<span foreground='orange'>Replaces the profile '" +
+                        Glib::Markup::escape_text(old_profile->name) + "' of this device</span>");
+  }
+
+  Gtk::HBox& name_box = *Gtk::manage(new Gtk::HBox());
+  name_box.set_spacing(5);
+  name_box.pack_start(*Gtk::manage(new Gtk::Label("Name:")), Gtk::PACK_SHRINK);
+  name_box.pack_start(m_name, Gtk::PACK_EXPAND_WIDGET);
+
+  get_vbox()->set_spacing(5);
+  get_vbox()->pack_start(m_label, Gtk::PACK_SHRINK);
+  get_vbox()->pack_start(name_box, Gtk::PACK_SHRINK);
+  get_vbox()->pack_start(m_save_calibration, Gtk::PACK_SHRINK);
+  get_vbox()->pack_start(m_save_mapping, Gtk::PACK_SHRINK);
+  get_vbox()->pack_start(m_status, Gtk::PACK_SHRINK);
+
+  add_button(Gtk::Stock::CANCEL, 1);
+  Gtk::Widget* ok_button = add_button(Gtk::Stock::OK, 0);
+  ok_button->set_sensitive(!joystick.get_stable_id().empty());
+
+  signal_response().connect(sigc::mem_fun(this, &SaveProfileDialog::on_response));
+}
+
+bool
+SaveProfileDialog::save()
+{
+  JoystickProfile profile;
+  profile.stable_id    = m_joystick.get_stable_id();
+  profile.name         = m_name.get_text();
+  profile.axis_count   = m_joystick.get_axis_count();
+  profile.button_count = m_joystick.get_button_count();
+
+  try
+  {
+    if (m_save_calibration.get_active())
+    {
+      profile.has_calibration = true;
+      profile.corr = m_joystick.get_corr();
+    }
+
+    if (m_save_mapping.get_active())
+    {
+      profile.has_mapping = true;
+      profile.axis_mapping = m_joystick.get_axis_mapping();
+      profile.button_mapping = m_joystick.get_button_mapping();
+    }
+
+    ProfileStore& store = Main::current()->get_profile_store();
+    store.save(profile);
+    m_verbose and std::cout << "wrote " << store.get_filename(profile.stable_id) << std::endl;
+    return true;
+  }
+  catch(const std::exception& err)
+  {
+    std::cout << err.what() << std::endl;
+    m_status.set_markup("<span foreground='red'>" + Glib::Markup::escape_text(err.what()) + "</span>");
+    return false;
+  }
+}
+
+void
+SaveProfileDialog::on_response(int v)
+{
+  if (v == 0)
+  {
+    if (save())
+    {
+      hide();
+    }
+  }
+  else
+  {
+    hide();
+  }
+}
+
+/* EOF */
@@ -0,0 +1,56 @@
+/*
+**  jstest-gtk - A graphical joystick tester
+**  Copyright (C) 2025 Raphael Rosch <jstest-bugs@insaner.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HEADER_JSTEST_GTK_SAVE_PROFILE_DIALOG_HPP
+#define HEADER_JSTEST_GTK_SAVE_PROFILE_DIALOG_HPP
+
+#include <gtkmm/box.h>
+#include <gtkmm/checkbutton.h>
+#include <gtkmm/dialog.h>
+#include <gtkmm/entry.h>
+#include <gtkmm/label.h>
+
+class Joystick;
+
+/** Saves the current calibration and mapping of a device as a profile
+    that gets applied whenever the device is plugged in again */
+class SaveProfileDialog : public Gtk::Dialog
+{
+private:
+  Joystick& m_joystick;
+
+  Gtk::Label m_label;
+  Gtk::Entry m_name;
+  Gtk::CheckButton m_save_calibration;
+  Gtk::CheckButton m_save_mapping;
+  Gtk::Label m_status;
+
+public:
+  SaveProfileDialog(Joystick& joystick);
+
+private:
+  void on_response(int v);
+  bool save();
+
+  SaveProfileDialog(const SaveProfileDialog&);
+  SaveProfileDialog& operator=(const SaveProfileDialog&);
+};
+
+#endif
+
+/* EOF */
@@ -0,0 +1,428 @@
+/*
+**  jstest-gtk - A graphical joystick tester
+**  Copyright (C) 2025 Raphael Rosch <jstest-bugs@insaner.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdio.h>
+#include <string.h>
+
+#include "sdl_mapping.hpp"
+#include "verbose.hpp"
+
+namespace {
+
+int hex_digit(char c)
+{
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+/** Reads the little endian 16 bit word at hex digit \a pos */
+bool get_guid_word(const char* str, int pos, uint16_t& word)
+{
+  int value = 0;
+  // byte order in the string is low byte first
+  const int order[4] = { 2, 3, 0, 1 };
+  for(int i = 0; i < 4; ++i)
+  {
+    int digit = hex_digit(str[pos + order[i]]);
+    if (digit < 0)
+      return false;
+    value = (value << 4) | digit;
+  }
+  word = value;
+  return true;
+}
+
+struct SdlTarget
+{
+  const char* sdl_name;
+  const char* label;
+};
+
+const SdlTarget sdl_targets[] = {
+  { "a",             "A" },
+  { "b",             "B" },
+  { "x",             "X" },
+  { "y",             "Y" },
+  { "back",          "Back" },
+  { "guide",         "Guide" },
+  { "start",         "Start" },
+  { "leftstick",     "LS" },
+  { "rightstick",    "RS" },
+  { "leftshoulder",  "LB" },
+  { "rightshoulder", "RB" },
+  { "dpup",          "D-Pad Up" },
+  { "dpdown",        "D-Pad Down" },
+  { "dpleft",        "D-Pad Left" },
+  { "dpright",       "D-Pad Right" },
+  { "misc1",         "Misc" },
+  { "paddle1",       "P1" },
+  { "paddle2",       "P2" },
+  { "paddle3",       "P3" },
+  { "paddle4",       "P4" },
+  { "touchpad",      "Touchpad" },
+  { "leftx",         "Left X" },
+  { "lefty",         "Left Y" },
+  { "rightx",        "Right X" },
+  { "righty",        "Right Y" },
+  { "lefttrigger",   "LT" },
+  { "righttrigger",  "RT" },
+};
+
+std::string get_target_label(const std::string& target)
+{
+  for(const auto& it : sdl_targets)
+  {
+    if (target == it.sdl_name)
+      return it.label;
+  }
+  return target;
+}
+
+/** Parses the number at \a str, returns -1 when there is none */
+int parse_index(const std::string& str, size_t pos, size_t& end)
+{
+  int value = -1;
+  for(end = pos; end < str.size() && str[end] >= '0' && str[end] <= '9'; ++end)
+  {
+    value = (value < 0 ? 0 : value * 10) + (str[end] - '0');
+    if (value > 1023)
+      return -1;
+  }
+  return value;
+}
+
+void add_label(std::map<int, std::string>& labels, int index, const std::string& label)
+{
+  std::string& slot = labels[index];
+  if (slot.empty())
+    slot = label;
+  else
+    slot += "/" + label; // half axes, e.g. both triggers on one axis
+}
+
+std::vector<Label> to_slots(const std::map<int, std::string>& labels)
+{
+  std::vector<Label> slots;
+  if (!labels.empty())
+  {
+    slots.resize(labels.rbegin()->first + 1);
+    for(const auto& it : labels)
+      slots[it.first] = it.second;
+  }
+  return slots;
+}
+
+} // namespace
+
+bool parse_sdl_guid(const char* str, size_t len, SdlGuid& guid)
+{
+  if (len != 32)
+    return false;
+
+  uint16_t crc, pad1, pad2;
+  if (!get_guid_word(str, 0, guid.bus) ||
+      !get_guid_word(str, 4, crc) ||
+      !get_guid_word(str, 8, guid.vendor) ||
+      !get_guid_word(str, 12, pad1) ||
+      !get_guid_word(str, 16, guid.product) ||
+      !get_guid_word(str, 20, pad2) ||
+      !get_guid_word(str, 24, guid.version))
+  {
+    return false;
+  }
+
+  // GUIDs of devices without ids carry the device name instead
+  return pad1 == 0 && pad2 == 0 && guid.vendor != 0;
+}
+
+bool parse_sdl_guid(const std::string& str, SdlGuid& guid)
+{
+  return parse_sdl_guid(str.data(), str.size(), guid);
+}
+
+std::string format_sdl_guid(const SdlGuid& guid)
+{
+  char buf[33];
+  snprintf(buf, sizeof(buf), "%02x%02x0000%02x%02x0000%02x%02x0000%02x%02x0000",
+           guid.bus & 0xff, guid.bus >> 8,
+           guid.vendor & 0xff, guid.vendor >> 8,
+           guid.product & 0xff, guid.product >> 8,
+           guid.version & 0xff, guid.version >> 8);
+  return buf;
+}
+
+bool parse_sdl_mapping(const std::string& mapping, JoystickConfig& config)
+{
+  std::vector<std::string> fields;
+  for(size_t pos = 0; pos <= mapping.size(); )
+  {
+    size_t comma = mapping.find(',', pos);
+    if (comma == std::string::npos)
+      comma = mapping.size();
+    fields.push_back(mapping.substr(pos, comma - pos));
+    pos = comma + 1;
+  }
+
+  SdlGuid guid;
+  if (fields.size() < 2 || !parse_sdl_guid(fields[0], guid))
+    return false;
+
+  char usb_id[16];
+  snprintf(usb_id, sizeof(usb_id), "%04x:%04x", guid.vendor, guid.product);
+  config.usb_ids.push_back(usb_id);
+  config.values["name"] = fields[1];
+  config.values["sdl_guid"] = fields[0];
+
+  std::map<int, std::string> axis_labels;
+  std::map<int, std::string> button_labels;
+  std::map<std::string, int> target_axis; // full axis bindings only
+
+  struct HatBinding { int hat; std::string target; };
+  std::vector<HatBinding> hats;
+  int axis_count = 0;
+
+  for(size_t i = 2; i < fields.size(); ++i)
+  {
+    const std::string& field = fields[i];
+    size_t colon = field.find(':');
+    if (colon == std::string::npos || colon + 1 >= field.size())
+      continue;
+
+    std::string target = field.substr(0, colon);
+    if (!target.empty() && (target[0] == '+' || target[0] == '-'))
+      target.erase(0, 1);
+    if (target == "platform" || target == "crc" || target == "hint" || target.compare(0, 3, "sdk") == 0)
+      continue;
+
+    size_t pos = colon + 1;
+    bool half = field[pos] == '+' || field[pos] == '-';
+    if (half)
+      pos += 1;
+
+    size_t end;
+    char kind = field[pos];
+    int index = parse_index(field, pos + 1, end);
+    if (index < 0)
+    {
+      m_verbose and std::cout << "sdl mapping: ignoring binding: " << field << std::endl;
+      continue;
+    }
+
+    if (kind == 'b')
+    {
+      add_label(button_labels, index, get_target_label(target));
+    }
+    else if (kind == 'a')
+    {
+      add_label(axis_labels, index, get_target_label(target));
+      axis_count = std::max(axis_count, index + 1);
+      if (!half)
+        target_axis[target] = index;
+    }
+    else if (kind == 'h')
+    {
+      hats.push_back(HatBinding{index, target});
+    }
+  }
+
+  // joydev lists hats as a pair of axes after the regular ones, where
+  // SDL counts them separately, so place them after the highest axis
+  // the mapping uses
+  int dpad_hat = -1;
+  for(const auto& binding : hats)
+  {
+    bool dpad = binding.target.compare(0, 2, "dp") == 0;
+    if (dpad && dpad_hat < 0)
+      dpad_hat = binding.hat;
+
+    int x = axis_count + 2 * binding.hat;
+    std::string& x_label = axis_labels[x];
+    std::string& y_label = axis_labels[x + 1];
+    if (x_label.empty())
+    {
+      std::ostringstream prefix;
+      if (dpad)
+        prefix << "D-Pad";
+      else
+        prefix << "Hat " << binding.hat;
+      x_label = prefix.str() + " X";
+      y_label = prefix.str() + " Y";
+    }
+  }
+
+  config.axes    = to_slots(axis_labels);
+  config.buttons = to_slots(button_labels);
+  for(const auto& label : config.buttons)
+  {
+    config.button_maxlen = std::max(config.button_maxlen, static_cast<int>(label.size()));
+  }
+
+  const char* sticks[2][2] = { { "leftx", "lefty" }, { "rightx", "righty" } };
+  for(const auto& stick : sticks)
+  {
+    auto x = target_axis.find(stick[0]);
+    auto y = target_axis.find(stick[1]);
+    if (x != target_axis.end() && y != target_axis.end())
+    {
+      config.stick_axes.push_back(x->second);
+      config.stick_axes.push_back(y->second);
+    }
+  }
+  if (dpad_hat >= 0 && config.stick_axes.size() < 6)
+  {
+    config.stick_axes.push_back(axis_count + 2 * dpad_hat);
+    config.stick_axes.push_back(axis_count + 2 * dpad_hat + 1);
+  }
+
+  const char* triggers[] = { "lefttrigger", "righttrigger" };
+  for(const auto& trigger : triggers)
+  {
+    auto it = target_axis.find(trigger);
+    if (it != target_axis.end())
+      config.trigger_axes.push_back(it->second);
+  }
+
+  return true;
+}
+
+int load_sdl_mappings(const std::string& filename, JoystickConfigRegistry& registry)
+{
+  std::ifstream in(filename);
+  if (!in)
+    return 0;
+
+  int count = 0;
+  int line_number = 0;
+  std::string line;
+  while (std::getline(in, line))
+  {
+    line_number += 1;
+
+    if (!line.empty() && line[line.size() - 1] == '\r')
+      line.erase(line.size() - 1);
+    if (line.empty() || line[0] == '#')
+      continue;
+
+    // the database covers all platforms, only the Linux GUIDs can
+    // match a joydev device
+    if (line.find("platform:Linux") == std::string::npos)
+      continue;
+
+    size_t comma = line.find(',');
+    SdlGuid guid;
+    if (comma == std::string::npos || !parse_sdl_guid(line.data(), comma, guid))
+    {
+      m_verbose and std::cout << filename << ":" << line_number << ": skipping mapping without usable GUID" << std::endl;
+      continue;
+    }
+
+    registry.add_sdl_mapping(guid.pack(), guid.pack_usb_id(), line);
+    count += 1;
+  }
+
+  m_verbose and std::cout << filename << ": " << count << " SDL mappings" << std::endl;
+  return count;
+}
+
+#ifdef __TEST__
+
+// g++ -std=c++11 -O2 -c joystick_config_files.cpp parallel_for.cpp `pkg-config --cflags gtkmm-3.0`
+// g++ -std=c++11 -O2 -D__TEST__ sdl_mapping.cpp joystick_config_files.o parallel_for.o -o sdl-mapping-test -pthread `pkg-config --cflags gtkmm-3.0`
+
+#include <chrono>
+#include <stdlib.h>
+#include <unistd.h>
+
+bool m_verbose = false;
+
+int main(int argc, char** argv)
+{
+  typedef std::chrono::steady_clock Clock;
+
+  // roughly the shape of the upstream database: about a third of the
+  // mappings are for Linux
+  const int mapping_count = argc > 1 ? atoi(argv[1]) : 6000;
+  const char* platforms[] = { "Windows", "Mac OS X", "Linux" };
+
+  char filename[] = "/tmp/jstest-gtk-gamecontrollerdb-XXXXXX";
+  int fd = mkstemp(filename);
+  close(fd);
+  {
+    std::ofstream out(filename);
+    out << "# Game Controller DB for SDL\n\n";
+    for (int i = 0; i < mapping_count; ++i) {
+      SdlGuid guid;
+      guid.bus = 0x0003;
+      guid.vendor = 0x1000 + i / 256;
+      guid.product = i % 256;
+      guid.version = 0x0110;
+      out << format_sdl_guid(guid) << ",Generated Pad " << i
+          << ",a:b0,b:b1,back:b6,dpdown:h0.4,dpleft:h0.8,dpright:h0.2,dpup:h0.1,guide:b8,"
+          << "leftshoulder:b4,leftstick:b9,lefttrigger:a2,leftx:a0,lefty:a1,rightshoulder:b5,"
+          << "rightstick:b10,righttrigger:a5,rightx:a3,righty:a4,start:b7,x:b2,y:b3,"
+          << "platform:" << platforms[i % 3] << ",\n";
+    }
+  }
+
+  Clock::time_point start = Clock::now();
+  JoystickConfigRegistry registry;
+  int count = load_sdl_mappings(filename, registry);
+  double load_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+  start = Clock::now();
+  size_t labels = 0;
+  for (const auto& config : registry.get_configs()) {
+    labels += config->axes.size() + config->buttons.size();
+  }
+  double translate_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+  // Xbox 360 pad as listed upstream
+  JoystickConfig config;
+  bool ok = parse_sdl_mapping("030000005e0400008e02000010010000,Xbox 360 Controller,a:b0,b:b1,back:b6,"
+                              "dpdown:h0.4,dpleft:h0.8,dpright:h0.2,dpup:h0.1,guide:b8,leftshoulder:b4,"
+                              "leftstick:b9,lefttrigger:a2,leftx:a0,lefty:a1,rightshoulder:b5,rightstick:b10,"
+                              "righttrigger:a5,rightx:a3,righty:a4,start:b7,x:b2,y:b3,platform:Linux,", config);
+  ok = (ok &&
+        config.usb_ids.size() == 1 && config.usb_ids[0] == "045e:028e" &&
+        config.buttons.size() == 11 && config.buttons[0] == "A" && config.buttons[8] == "Guide" &&
+        config.axes.size() == 8 && config.axes[2] == "LT" && config.axes[6] == "D-Pad X" &&
+        config.stick_axes == std::vector<unsigned int>({0, 1, 3, 4, 6, 7}) &&
+        config.trigger_axes == std::vector<unsigned int>({2, 5}));
+
+  SdlGuid guid;
+  guid.bus = 0x0003; guid.vendor = 0x045e; guid.product = 0x028e; guid.version = 0x0110;
+  ok = ok && format_sdl_guid(guid) == "030000005e0400008e02000010010000";
+
+  std::cout << "mappings:          " << count << " Linux of " << mapping_count << "\n"
+            << "load + index:      " << load_ms << " ms\n"
+            << "translate all:     " << translate_ms << " ms (" << labels << " labels)\n"
+            << "xbox360 mapping:   " << (ok ? "ok" : "WRONG") << std::endl;
+
+  unlink(filename);
+  return ok ? 0 : 1;
+}
+#endif
+
+/* EOF */
@@ -0,0 +1,67 @@
+/*
+**  jstest-gtk - A graphical joystick tester
+**  Copyright (C) 2025 Raphael Rosch <jstest-bugs@insaner.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HEADER_JSTEST_GTK_SDL_MAPPING_HPP
+#define HEADER_JSTEST_GTK_SDL_MAPPING_HPP
+
+#include <stdint.h>
+#include <string>
+
+#include "joystick_config_files.hpp"
+
+/** The parts of an SDL joystick GUID that identify a device on Linux */
+struct SdlGuid
+{
+  uint16_t bus;
+  uint16_t vendor;
+  uint16_t product;
+  uint16_t version;
+
+  SdlGuid() : bus(0), vendor(0), product(0), version(0) {}
+
+  uint64_t pack() const
+  {
+    return ((uint64_t(bus) << 48) | (uint64_t(vendor) << 32) |
+            (uint64_t(product) << 16) | uint64_t(version));
+  }
+
+  uint32_t pack_usb_id() const { return (uint32_t(vendor) << 16) | product; }
+};
+
+/** Parses the 32 hex digit GUID SDL uses on Linux: little endian
+    bus, name crc, vendor, 0, product, 0, version, driver data. The crc
+    and driver data are ignored. Returns false for GUIDs that aren't
+    built from a vendor and product id. */
+bool parse_sdl_guid(const char* str, size_t len, SdlGuid& guid);
+bool parse_sdl_guid(const std::string& str, SdlGuid& guid);
+
+std::string format_sdl_guid(const SdlGuid& guid);
+
+/** Translates an SDL mapping string ("guid,name,a:b0,leftx:a0,...")
+    into axis and button labels and a stick layout. Returns false when
+    \a mapping is malformed. */
+bool parse_sdl_mapping(const std::string& mapping, JoystickConfig& config);
+
+/** Adds the Linux mappings of a gamecontrollerdb.txt to \a registry.
+    Only the GUIDs are read, a mapping is translated when it is first
+    looked up. Returns the number of mappings added. */
+int load_sdl_mappings(const std::string& filename, JoystickConfigRegistry& registry);
+
+#endif
+
+/* EOF */
@@ -0,0 +1,275 @@
+/*
+**  jstest-gtk - A graphical joystick tester
+**  Copyright (C) 2025 Raphael Rosch <jstest-bugs@insaner.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <math.h>
+
+#include "streaming_histogram.hpp"
+
+StreamingHistogram::StreamingHistogram(int bin_count) :
+  m_bins(bin_count),
+  m_origin(0),
+  m_width(1),
+  m_count(0),
+  m_min(0),
+  m_max(0)
+{
+}
+
+void
+StreamingHistogram::clear()
+{
+  std::fill(m_bins.begin(), m_bins.end(), 0);
+  m_origin = 0;
+  m_width  = 1;
+  m_count  = 0;
+  m_min    = 0;
+  m_max    = 0;
+}
+
+void
+StreamingHistogram::add(int value, uint32_t weight)
+{
+  if (m_count == 0)
+  {
+    m_origin = value - static_cast<int>(m_bins.size()) / 2;
+    m_min = m_max = value;
+  }
+  else
+  {
+    m_min = std::min(m_min, value);
+    m_max = std::max(m_max, value);
+    grow(value);
+  }
+
+  m_bins[(value - m_origin) / m_width] += weight;
+  m_count += weight;
+}
+
+void
+StreamingHistogram::grow(int value)
+{
+  const int size = static_cast<int>(m_bins.size());
+  while (value < m_origin || value - m_origin >= size * m_width)
+  {
+    // double the width and extend the range towards the value, the
+    // old bins stay aligned so each new bin is two old ones
+    int offset = 0;
+    if (value < m_origin)
+    {
+      m_origin -= size * m_width;
+      offset = size / 2;
+    }
+    m_width *= 2;
+
+    std::vector<uint32_t> bins(size);
+    for(int i = 0; i < size; ++i)
+    {
+      bins[offset + i / 2] += m_bins[i];
+    }
+    m_bins.swap(bins);
+  }
+}
+
+int
+StreamingHistogram::percentile(double p) const
+{
+  if (m_count == 0)
+    return 0;
+
+  double target = std::min(std::max(p, 0.0), 1.0) * m_count;
+  double seen = 0;
+  for(size_t i = 0; i < m_bins.size(); ++i)
+  {
+    if (m_bins[i] && seen + m_bins[i] >= target)
+    {
+      double fraction = (target - seen) / m_bins[i];
+      int value = m_origin + static_cast<int>(i) * m_width + static_cast<int>(fraction * (m_width - 1) + 0.5);
+      return std::min(std::max(value, m_min), m_max);
+    }
+    seen += m_bins[i];
+  }
+  return m_max;
+}
+
+uint64_t
+StreamingHistogram::count_below(int value) const
+{
+  uint64_t result = 0;
+  for(size_t i = 0; i < m_bins.size(); ++i)
+  {
+    int bin_end = m_origin + static_cast<int>(i + 1) * m_width;
+    if (bin_end > value)
+      break;
+    result += m_bins[i];
+  }
+  return result;
+}
+
+uint64_t
+StreamingHistogram::count_above(int value) const
+{
+  uint64_t result = 0;
+  for(size_t i = m_bins.size(); i-- > 0; )
+  {
+    int bin_start = m_origin + static_cast<int>(i) * m_width;
+    if (bin_start <= value)
+      break;
+    result += m_bins[i];
+  }
+  return result;
+}
+
+AxisCalibrationEstimate estimate_axis_calibration(const StreamingHistogram& rest,
+                                                  const StreamingHistogram& range)
+{
+  AxisCalibrationEstimate result;
+  result.confidence = 1.0;
+
+  auto limit = [&result](double confidence, const char* problem) {
+    if (confidence < result.confidence)
+    {
+      result.confidence = std::max(confidence, 0.0);
+      result.problem = problem;
+    }
+  };
+
+  result.range_min  = range.percentile(0.002);
+  result.range_max  = range.percentile(0.998);
+  result.center_min = rest.percentile(0.001);
+  result.center_max = rest.percentile(0.999);
+
+  int span  = result.range_max - result.range_min;
+  int noise = result.center_max - result.center_min;
+
+  if (range.count() == 0 || span <= 0)
+  {
+    result.range_min  = rest.min() - 1;
+    result.range_max  = rest.max() + 1;
+    result.center_min = result.center_max = rest.percentile(0.5);
+    result.confidence = 0.0;
+    result.problem = "not moved";
+    return result;
+  }
+
+  // an axis resting at one end is a trigger or throttle, where a
+  // center deadzone makes no sense
+  int rest_center = rest.count() ? rest.percentile(0.5) : (result.range_min + result.range_max) / 2;
+  int edge_margin = std::max(noise, span / 50);
+  if (rest_center - result.range_min <= edge_margin ||
+      result.range_max - rest_center <= edge_margin)
+  {
+    result.center_min = result.center_max = (result.range_min + result.range_max) / 2;
+  }
+  else
+  {
+    result.center_min = std::max(result.center_min, result.range_min + 1);
+    result.center_max = std::min(result.center_max, result.range_max - 1);
+  }
+
+  limit(rest.count() / 50.0, "rest not measured");
+  limit(range.count() / 500.0, "too few samples");
+  limit(span / (16.0 * (noise + 1)), "barely moved");
+  if (noise > span / 10)
+    limit(0.3, "noisy at rest");
+
+  // the ends need to have been held for a bit, otherwise the range
+  // comes from a single sweep through them
+  int end_band = std::max(span / 50, 1);
+  double expected = 0.01 * range.count();
+  limit(range.count_below(result.range_min + end_band) / expected, "minimum not reached");
+  limit(range.count_above(result.range_max - end_band) / expected, "maximum not reached");
+
+  return result;
+}
+
+#ifdef __TEST__
+
+// g++ -std=c++11 -O2 -D__TEST__ streaming_histogram.cpp -o streaming-histogram-test
+
+#include <iostream>
+#include <random>
+
+int main(int argc, char** argv)
+{
+  bool ok = true;
+  std::mt19937 rng(0);
+
+  // 8 bit axis stays exact
+  StreamingHistogram small;
+  for(int i = 0; i < 1000; ++i)
+    small.add(i % 256);
+  ok = ok && small.bin_width() == 1 && small.percentile(0.0) == 0 && small.percentile(1.0) == 255;
+
+  // full range with a stick that rests at 120 +-30, swept to
+  // -32000..31000 and two single spikes to the limits
+  StreamingHistogram rest;
+  StreamingHistogram range;
+  std::normal_distribution<double> noise(120, 10);
+  for(int i = 0; i < 200; ++i)
+    rest.add(static_cast<int>(noise(rng)));
+
+  std::uniform_real_distribution<double> angle(0, 2 * M_PI);
+  for(int i = 0; i < 5000; ++i)
+  {
+    // circling along the rim spends most time near the ends
+    double v = sin(angle(rng));
+    range.add(v < 0 ? static_cast<int>(v * 32000) : static_cast<int>(v * 31000));
+  }
+  range.add(-32767);
+  range.add(32767);
+
+  AxisCalibrationEstimate stick = estimate_axis_calibration(rest, range);
+  std::cout << "stick:   range " << stick.range_min << ".." << stick.range_max
+            << " center " << stick.center_min << ".." << stick.center_max
+            << " confidence " << stick.confidence << " " << stick.problem
+            << " (bin width " << range.bin_width() << ")" << std::endl;
+  ok = ok && abs(stick.range_min + 32000) < 200 && abs(stick.range_max - 31000) < 200;
+  ok = ok && stick.center_min > 60 && stick.center_min < 120 && stick.center_max > 120 && stick.center_max < 180;
+  ok = ok && stick.confidence > 0.9;
+
+  // a trigger resting at the minimum gets its center in the middle
+  StreamingHistogram trigger_rest;
+  StreamingHistogram trigger_range;
+  for(int i = 0; i < 200; ++i)
+    trigger_rest.add(-32767);
+  for(int i = 0; i < 2000; ++i)
+    trigger_range.add(i < 1000 ? -32767 : -32767 + (i - 1000) * 65);
+  for(int i = 0; i < 100; ++i)
+    trigger_range.add(32767);
+  AxisCalibrationEstimate trigger = estimate_axis_calibration(trigger_rest, trigger_range);
+  std::cout << "trigger: range " << trigger.range_min << ".." << trigger.range_max
+            << " center " << trigger.center_min << ".." << trigger.center_max
+            << " confidence " << trigger.confidence << " " << trigger.problem << std::endl;
+  ok = ok && trigger.center_min == trigger.center_max && abs(trigger.center_min) < 200;
+
+  // an axis that was only nudged gets a low confidence
+  StreamingHistogram nudged;
+  for(int i = 0; i < 1000; ++i)
+    nudged.add(100 + i % 300);
+  AxisCalibrationEstimate weak = estimate_axis_calibration(rest, nudged);
+  std::cout << "nudged:  confidence " << weak.confidence << " " << weak.problem << std::endl;
+  ok = ok && weak.confidence < 0.5;
+
+  std::cout << (ok ? "ok" : "WRONG") << std::endl;
+  return ok ? 0 : 1;
+}
+
+#endif
+
+/* EOF */
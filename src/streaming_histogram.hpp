@@ -0,0 +1,94 @@
+/*
+**  jstest-gtk - A graphical joystick tester
+**  Copyright (C) 2025 Raphael Rosch <jstest-bugs@insaner.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HEADER_JSTEST_GTK_STREAMING_HISTOGRAM_HPP
+#define HEADER_JSTEST_GTK_STREAMING_HISTOGRAM_HPP
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/** Histogram of integer samples in a fixed number of bins. The bins
+    start one value wide around the first sample and double in width,
+    merging pairs, whenever a sample falls outside, so small ranges
+    like those of 8 bit axes stay exact and a full 16 bit range still
+    resolves to 1/1024th. */
+class StreamingHistogram
+{
+private:
+  std::vector<uint32_t> m_bins;
+  int m_origin; // value at the start of the first bin
+  int m_width;  // values per bin, a power of two
+  uint64_t m_count;
+  int m_min;
+  int m_max;
+
+public:
+  explicit StreamingHistogram(int bin_count = 1024);
+
+  /** \a weight counts as that many samples, e.g. the time the value
+      was held */
+  void add(int value, uint32_t weight = 1);
+  void clear();
+
+  uint64_t count() const { return m_count; }
+  int min() const { return m_min; }
+  int max() const { return m_max; }
+  int bin_width() const { return m_width; }
+  int bin_count() const { return static_cast<int>(m_bins.size()); }
+  uint32_t bin(int i) const { return m_bins[i]; }
+  /** Smallest value that falls into bin \a i */
+  int bin_start(int i) const { return m_origin + i * m_width; }
+
+  /** The value below which a fraction \a p of the samples lie,
+      interpolated within the bin */
+  int percentile(double p) const;
+
+  /** Number of samples below \a value, exact up to the bin width */
+  uint64_t count_below(int value) const;
+  uint64_t count_above(int value) const;
+
+private:
+  void grow(int value);
+};
+
+/** Calibration of one axis estimated from its resting noise and the
+    range it was moved through */
+struct AxisCalibrationEstimate
+{
+  int center_min;
+  int center_max;
+  int range_min;
+  int range_max;
+
+  /** 0 to 1, how much the samples can be trusted, \a problem names the
+      weakest point when it is below 1 */
+  double confidence;
+  std::string problem;
+};
+
+/** Takes the range from the 0.2/99.8 percentiles of \a range, so a few
+    spikes don't count, and the deadzone from the noise band of
+    \a rest. Axes that rest at one end, like triggers, get their center
+    in the middle and no deadzone. */
+AxisCalibrationEstimate estimate_axis_calibration(const StreamingHistogram& rest,
+                                                  const StreamingHistogram& range);
+
+#endif
+
+/* EOF */
@@ -20,13 +20,23 @@
 
 ThrottleWidget::ThrottleWidget(int width, int height, bool invert_)
   : invert(invert_),
-    pos(0.0)
+    pos(0.0),
+    has_travel(false),
+    travel()
 {
   set_size_request(width, height);
   //modify_bg(Gtk::STATE_NORMAL , Gdk::Color("white"));
   //modify_fg(Gtk::STATE_NORMAL , Gdk::Color("black"));
 }
 
+double
+ThrottleWidget::get_fill(double p) const
+{
+  if (invert)
+    p = -p;
+  return 1.0 - (p + 1.0) / 2.0;
+}
+
 bool
 ThrottleWidget::on_draw(const ::Cairo::RefPtr< ::Cairo::Context>& cr)
 {
@@ -47,6 +57,48 @@ ThrottleWidget::on_draw(const ::Cairo::RefPtr< ::Cairo::Context>& cr)
     cr->rectangle(0, h - dh, w, dh);
     cr->fill();
 
+  if (has_travel)
+  {
+    // press curve grows from the left edge, release curve from the right
+    size_t bins = travel.press_curve.size();
+    for(size_t i = 0; i < bins && i < travel.release_curve.size(); ++i)
+    {
+      double y0 = h - h * get_fill(-1.0 + 2.0 * i / bins);
+      double y1 = h - h * get_fill(-1.0 + 2.0 * (i + 1) / bins);
+
+      cr->set_source_rgba(0.2, 0.5, 1.0, 0.8);
+      cr->rectangle(0, y0, w / 3.0 * travel.press_curve[i], y1 - y0);
+      cr->fill();
+
+      cr->set_source_rgba(1.0, 0.6, 0.0, 0.8);
+      cr->rectangle(w, y0, -w / 3.0 * travel.release_curve[i], y1 - y0);
+      cr->fill();
+    }
+
+    cr->set_line_width(2.0);
+
+    cr->set_source_rgb(0.0, 0.8, 0.0);
+    cr->move_to(0, h - h * get_fill(travel.first_movement));
+    cr->rel_line_to(w, 0);
+    cr->stroke();
+
+    cr->set_source_rgb(0.9, 0.0, 0.0);
+    cr->move_to(0, h - h * get_fill(travel.saturation));
+    cr->rel_line_to(w, 0);
+    cr->stroke();
+
+    // thresholds as ticks on the side of their curve
+    cr->set_source_rgb(0.2, 0.5, 1.0);
+    cr->move_to(-5, h - h * get_fill(travel.press));
+    cr->rel_line_to(w / 2.0 + 5, 0);
+    cr->stroke();
+
+    cr->set_source_rgb(1.0, 0.6, 0.0);
+    cr->move_to(w / 2.0, h - h * get_fill(travel.release));
+    cr->rel_line_to(w / 2.0 + 5, 0);
+    cr->stroke();
+  }
+
   return true;
 }
 
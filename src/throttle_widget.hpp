@@ -20,20 +20,44 @@
 #define HEADER_JSTEST_GTK_THROTTLE_WIDGET_HPP
 
 #include <gtkmm/drawingarea.h>
+#include <vector>
 
 class ThrottleWidget : public Gtk::DrawingArea
 {
+public:
+  /** Usable travel drawn over the bar, positions are in set_pos()
+      units, the curves hold 0-1 per bin with the bins evenly covering
+      -1 to 1 */
+  struct Travel
+  {
+    double first_movement;
+    double saturation;
+    double press;
+    double release;
+    std::vector<double> press_curve;
+    std::vector<double> release_curve;
+  };
+
 private:
   bool invert;
   double pos;
 
+  bool has_travel;
+  Travel travel;
+
 public:
   ThrottleWidget(int width, int height, bool invert = false);
 
   bool on_draw(const ::Cairo::RefPtr< ::Cairo::Context>& cr) override;
   void set_pos(double p);
 
+  void set_travel(const Travel& travel);
+  void clear_travel();
+
 private:
+  /** Height of the bar at position \a p, 0-1 */
+  double get_fill(double p) const;
+
   ThrottleWidget(const ThrottleWidget&);
   ThrottleWidget& operator=(const ThrottleWidget&);
 };
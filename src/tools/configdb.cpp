@@ -0,0 +1,352 @@
+/*
+**  jstest-gtk - A graphical joystick tester
+**  Copyright (C) 2025 Raphael Rosch <jstest-bugs@insaner.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Checks a directory of .config files and looks up usb_ids in it,
+// without GTK, so it can run in CI on the config database:
+//
+//   jstest-gtk-configdb check data/
+//   cut -f1 ids.txt | jstest-gtk-configdb lookup data/
+
+#include <algorithm>
+#include <chrono>
+#include <errno.h>
+#include <iostream>
+#include <linux/input.h>
+#include <map>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <unordered_map>
+
+#include "../joystick_config_files.hpp"
+#include "../parallel_for.hpp"
+
+bool m_verbose = false;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+// the limits of the joydev axis and button maps
+const size_t max_axes    = ABS_CNT;
+const size_t max_buttons = KEY_MAX - BTN_MISC + 1;
+
+double elapsed_ms(Clock::time_point start)
+{
+  return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+struct Database
+{
+  std::string directory;
+  std::vector<std::string> names;
+  std::vector<JoystickConfig> configs;
+  std::vector<std::vector<std::string> > warnings;
+
+  double readdir_ms;
+  double parse_ms;
+
+  Database() : directory(), names(), configs(), warnings(), readdir_ms(0), parse_ms(0) {}
+};
+
+void load_database(const std::string& directory, Database& db)
+{
+  db.directory = directory;
+
+  Clock::time_point start = Clock::now();
+  db.names = get_config_filenames(directory);
+  db.readdir_ms = elapsed_ms(start);
+
+  start = Clock::now();
+  db.configs.resize(db.names.size());
+  db.warnings.resize(db.names.size());
+  parallel_for(db.names.size(), [&](size_t i) {
+      db.configs[i] = load_config(directory + "/" + db.names[i], &db.warnings[i]);
+    });
+  db.parse_ms = elapsed_ms(start);
+}
+
+/** Index from packed usb_id to the file that claims it, the first file
+    in sorted order wins, same as in JoystickConfigRegistry */
+void build_index(const Database& db, std::unordered_map<uint32_t, size_t>& index)
+{
+  index.reserve(db.configs.size() * 2);
+  for(size_t i = 0; i < db.configs.size(); ++i)
+  {
+    for(const auto& usb_id : db.configs[i].usb_ids)
+    {
+      uint32_t key;
+      if (pack_usb_id(usb_id, key))
+      {
+        index.insert(std::make_pair(key, i));
+      }
+    }
+  }
+}
+
+bool is_png(const std::string& filename)
+{
+  static const unsigned char signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+
+  FILE* in = fopen(filename.c_str(), "rb");
+  if (!in)
+    return false;
+
+  unsigned char header[8];
+  bool ok = fread(header, 1, sizeof(header), in) == sizeof(header) &&
+    memcmp(header, signature, sizeof(signature)) == 0;
+  fclose(in);
+  return ok;
+}
+
+void check_slots(const std::string& filename, const char* prefix, const std::vector<Label>& slots,
+                 size_t max_slots, std::vector<std::string>& problems, std::vector<std::string>& warnings)
+{
+  for(size_t i = 0; i < slots.size(); ++i)
+  {
+    std::ostringstream str;
+    if (i >= max_slots && !slots[i].empty())
+    {
+      str << filename << ": " << prefix << i << " is out of range, joydev has at most " << max_slots;
+      problems.push_back(str.str());
+    }
+    else if (slots[i].empty())
+    {
+      // some controllers just don't have that button
+      str << filename << ": warning: " << prefix << i << " is missing, but there are higher ones";
+      warnings.push_back(str.str());
+    }
+  }
+}
+
+int check(const std::string& directory)
+{
+  Clock::time_point start = Clock::now();
+
+  Database db;
+  load_database(directory, db);
+
+  Clock::time_point index_start = Clock::now();
+  std::unordered_map<uint32_t, size_t> index;
+  build_index(db, index);
+  double index_ms = elapsed_ms(index_start);
+
+  // problems fail the check, warnings are about things jstest-gtk
+  // falls back on defaults for
+  std::vector<std::string> problems;
+  std::vector<std::string> warnings;
+  std::map<std::string, std::vector<size_t> > owners; // usb_id -> files claiming it
+  for(size_t i = 0; i < db.configs.size(); ++i)
+  {
+    const JoystickConfig& config = db.configs[i];
+    std::string name = directory + "/" + db.names[i];
+
+    problems.insert(problems.end(), db.warnings[i].begin(), db.warnings[i].end());
+
+    if (config.usb_ids.empty())
+      problems.push_back(name + ": claims no usb_id");
+
+    for(const auto& usb_id : config.usb_ids)
+    {
+      uint32_t key;
+      if (!pack_usb_id(usb_id, key))
+        problems.push_back(name + ": malformed usb_id '" + usb_id + "', expected vvvv:pppp in lower case hex");
+      else
+        owners[usb_id].push_back(i);
+    }
+
+    if (!config.js_type.empty() && !is_known_js_type(config.js_type))
+      warnings.push_back(name + ": warning: unknown js_type '" + config.js_type + "', the generic layout is used");
+
+    if (!config.icon_filename.empty())
+    {
+      // icons are looked up relative to the data directory, generic.png
+      // is shown instead of one that can't be loaded
+      std::string icon = directory + "/" + config.icon_filename;
+      if (access(icon.c_str(), R_OK) != 0)
+        warnings.push_back(name + ": warning: icon " + config.icon_filename + ": " + strerror(errno));
+      else if (!is_png(icon))
+        warnings.push_back(name + ": warning: icon " + config.icon_filename + " is not a PNG");
+    }
+
+    check_slots(name, "axis_", config.axes, max_axes, problems, warnings);
+    check_slots(name, "button_", config.buttons, max_buttons, problems, warnings);
+  }
+
+  for(const auto& it : owners)
+  {
+    // the same file listing a usb_id twice is harmless
+    std::vector<size_t> files = it.second;
+    files.erase(std::unique(files.begin(), files.end()), files.end());
+    if (files.size() > 1)
+    {
+      std::ostringstream str;
+      str << it.first << " is claimed by";
+      for(size_t file : files)
+        str << " " << directory << "/" << db.names[file];
+      str << ", " << db.names[files.front()] << " wins";
+      problems.push_back(str.str());
+    }
+  }
+
+  for(const auto& problem : problems)
+  {
+    std::cout << problem << "\n";
+  }
+
+  for(const auto& warning : warnings)
+  {
+    std::cout << warning << "\n";
+  }
+
+  std::cout << db.configs.size() << " files, " << index.size() << " usb_ids, "
+            << problems.size() << " problems, " << warnings.size() << " warnings\n"
+            << "readdir " << db.readdir_ms << " ms, parse " << db.parse_ms << " ms, index "
+            << index_ms << " ms, total " << elapsed_ms(start) << " ms" << std::endl;
+
+  return problems.empty() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int lookup(const std::string& directory)
+{
+  Database db;
+  load_database(directory, db);
+
+  std::unordered_map<uint32_t, size_t> index;
+  build_index(db, index);
+
+  // answers are collected and written in large blocks, one write per
+  // line would dominate the lookup time
+  std::ios::sync_with_stdio(false);
+  std::string out;
+  std::string line;
+  size_t count = 0;
+  Clock::time_point start = Clock::now();
+  while (std::getline(std::cin, line))
+  {
+    while (!line.empty() && (line.back() == '\r' || line.back() == ' '))
+      line.pop_back();
+
+    if (line.empty())
+      continue;
+
+    count += 1;
+    out += line;
+
+    // accept upper case ids as printed by some tools
+    std::string usb_id = line;
+    for(auto& c : usb_id)
+      c = tolower(c);
+
+    uint32_t key;
+    if (!pack_usb_id(usb_id, key))
+    {
+      out += "\tinvalid\n";
+    }
+    else
+    {
+      auto it = index.find(key);
+      if (it == index.end())
+      {
+        out += "\t-\n";
+      }
+      else
+      {
+        const JoystickConfig& config = db.configs[it->second];
+        out += "\t" + db.names[it->second] + "\t" + (config.js_type.empty() ? "-" : config.js_type) + "\n";
+      }
+    }
+
+    if (out.size() > 65536)
+    {
+      std::cout.write(out.data(), out.size());
+      out.clear();
+    }
+  }
+  std::cout.write(out.data(), out.size());
+  std::cout.flush();
+
+  m_verbose and std::cerr << count << " lookups in " << elapsed_ms(start) << " ms" << std::endl;
+  return EXIT_SUCCESS;
+}
+
+void print_usage(const char* argv0)
+{
+  std::cout << "Usage: " << argv0 << " [OPTIONS]... check DIRECTORY\n"
+            << "       " << argv0 << " [OPTIONS]... lookup DIRECTORY\n"
+            << "Checks the .config files in DIRECTORY, or reads vvvv:pppp usb_ids from\n"
+            << "stdin and prints the config file and js_type for each.\n"
+            << "\n"
+            << "check fails on problems only, warnings are about things jstest-gtk\n"
+            << "falls back on defaults for, like a missing icon or an unknown js_type.\n"
+            << "\n"
+            << "Options:\n"
+            << "  -h, --help      Display this help and exit\n"
+            << "  --verbose       Print useful extra information\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  std::vector<std::string> args;
+  for(int i = 1; i < argc; ++i)
+  {
+    if (strcmp("--help", argv[i]) == 0 ||
+        strcmp("-h", argv[i]) == 0)
+    {
+      print_usage(argv[0]);
+      return 0;
+    }
+    else if (strcmp("--verbose", argv[i]) == 0)
+    {
+      m_verbose = true;
+    }
+    else if (argv[i][0] == '-')
+    {
+      std::cout << "Error: " << argv[0] << ": unrecognized option '" << argv[i] << "'" << std::endl;
+      return EXIT_FAILURE;
+    }
+    else
+    {
+      args.push_back(argv[i]);
+    }
+  }
+
+  if (args.size() != 2)
+  {
+    print_usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+  else if (args[0] == "check")
+  {
+    return check(args[1]);
+  }
+  else if (args[0] == "lookup")
+  {
+    return lookup(args[1]);
+  }
+  else
+  {
+    std::cout << "Error: " << argv[0] << ": unknown command '" << args[0] << "'" << std::endl;
+    return EXIT_FAILURE;
+  }
+}
+
+/* EOF */
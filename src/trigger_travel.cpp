@@ -0,0 +1,263 @@
+/*
+**  jstest-gtk - A graphical joystick tester
+**  Copyright (C) 2025 Raphael Rosch <jstest-bugs@insaner.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "trigger_travel.hpp"
+
+TriggerTravelAnalyzer::TriggerTravelAnalyzer(int axis_count, int rest_band) :
+  m_axes(axis_count),
+  m_rest_band(rest_band)
+{
+  reset();
+}
+
+void
+TriggerTravelAnalyzer::reset_axis(Stats& stats)
+{
+  memset(&stats, 0, sizeof(stats));
+}
+
+void
+TriggerTravelAnalyzer::reset()
+{
+  for(auto& stats : m_axes)
+  {
+    reset_axis(stats);
+  }
+}
+
+void
+TriggerTravelAnalyzer::set_rest(int axis, int value)
+{
+  if (axis < 0 || axis >= static_cast<int>(m_axes.size()))
+    return;
+
+  Stats& stats = m_axes[axis];
+  reset_axis(stats);
+  stats.has_rest = true;
+  stats.rest = value;
+  stats.last = value;
+}
+
+int
+TriggerTravelAnalyzer::get_bin(int value)
+{
+  int bin = (value + 32768) / (65536 / curve_size);
+  return bin < 0 ? 0 : (bin >= curve_size ? curve_size - 1 : bin);
+}
+
+bool
+TriggerTravelAnalyzer::add(int axis, int value)
+{
+  if (axis < 0 || axis >= static_cast<int>(m_axes.size()))
+    return false;
+
+  Stats& stats = m_axes[axis];
+  if (!stats.has_rest)
+  {
+    set_rest(axis, value);
+    return false;
+  }
+
+  int distance = abs(value - stats.rest);
+  int last_distance = abs(stats.last - stats.rest);
+  bool changed = false;
+
+  if (distance > last_distance)
+    stats.press_curve[get_bin(value)] += 1;
+  else if (distance < last_distance)
+    stats.release_curve[get_bin(value)] += 1;
+
+  if (distance > m_rest_band)
+  {
+    if (!stats.pressed)
+    {
+      stats.pressed = true;
+      stats.presses += 1;
+      stats.press_sum += value;
+      changed = true;
+
+      if (stats.presses == 1)
+      {
+        stats.first_movement = value;
+        stats.saturation = value;
+      }
+    }
+
+    if (distance < abs(stats.first_movement - stats.rest))
+    {
+      stats.first_movement = value;
+      changed = true;
+    }
+
+    int saturation_distance = abs(stats.saturation - stats.rest);
+    if (distance > saturation_distance)
+    {
+      stats.saturation = value;
+      stats.saturation_events = 1;
+      changed = true;
+    }
+    else if (distance == saturation_distance)
+    {
+      stats.saturation_events += 1;
+    }
+  }
+  else if (stats.pressed)
+  {
+    stats.pressed = false;
+    stats.releases += 1;
+    stats.release_sum += stats.last;
+    changed = true;
+  }
+
+  stats.last = value;
+  return changed;
+}
+
+void
+TriggerTravelAnalyzer::resume(int axis, int value)
+{
+  if (axis < 0 || axis >= static_cast<int>(m_axes.size()))
+    return;
+
+  Stats& stats = m_axes[axis];
+  if (!stats.has_rest)
+  {
+    set_rest(axis, value);
+    return;
+  }
+
+  // a press that is still going on continues, one that ended while
+  // the device was gone isn't counted, where it ended is unknown
+  stats.pressed = stats.pressed && abs(value - stats.rest) > m_rest_band;
+  stats.last = value;
+}
+
+int
+TriggerTravelAnalyzer::get_press_threshold(int axis) const
+{
+  const Stats& stats = m_axes[axis];
+  return stats.presses ? static_cast<int>(stats.press_sum / stats.presses) : stats.rest;
+}
+
+int
+TriggerTravelAnalyzer::get_release_threshold(int axis) const
+{
+  const Stats& stats = m_axes[axis];
+  return stats.releases ? static_cast<int>(stats.release_sum / stats.releases) : stats.rest;
+}
+
+int
+TriggerTravelAnalyzer::get_hysteresis(int axis) const
+{
+  const Stats& stats = m_axes[axis];
+  if (!stats.presses || !stats.releases)
+    return 0;
+
+  return abs(get_press_threshold(axis) - stats.rest) - abs(get_release_threshold(axis) - stats.rest);
+}
+
+#ifdef __TEST__
+
+// g++ -std=c++11 -O2 -D__TEST__ trigger_travel.cpp -o trigger-travel-test
+
+#include <iostream>
+#include <random>
+
+int main(int argc, char** argv)
+{
+  bool ok = true;
+  std::mt19937 rng(0);
+  std::uniform_int_distribution<int> noise(-100, 100);
+  std::uniform_int_distribution<int> depth(60, 100);
+
+  // a trigger resting at -32767 that only starts reporting at 10% of
+  // its travel on the way in but keeps reporting down to 5% on the way
+  // out, and saturates at 90% of the travel
+  TriggerTravelAnalyzer analyzer(2);
+  analyzer.set_rest(1, -32767);
+  auto report = [](int percent, int threshold) {
+    if (percent < threshold)
+      return -32767;
+    int value = -32767 + percent * 65534 / 90;
+    return value > 32767 ? 32767 : value;
+  };
+  for(int press = 0; press < 100; ++press)
+  {
+    int bottom = depth(rng);
+    for(int i = 0; i <= bottom; ++i)
+    {
+      int value = report(i, 10);
+      analyzer.add(1, abs(value) == 32767 ? value : value + noise(rng));
+    }
+    for(int i = bottom; i >= 0; --i)
+    {
+      int value = report(i, 5);
+      analyzer.add(1, abs(value) == 32767 ? value : value + noise(rng));
+    }
+  }
+
+  const TriggerTravelAnalyzer::Stats& stats = analyzer.get_stats(1);
+  std::cout << "rest " << stats.rest
+            << ", first movement " << stats.first_movement
+            << ", saturation " << stats.saturation << " (" << stats.saturation_events << " events)"
+            << ", " << stats.presses << " presses, " << stats.releases << " releases"
+            << ", press at " << analyzer.get_press_threshold(1)
+            << ", release at " << analyzer.get_release_threshold(1)
+            << ", hysteresis " << analyzer.get_hysteresis(1) << std::endl;
+  std::cout << "press/release curves:";
+  for(int i = 0; i < TriggerTravelAnalyzer::curve_size; ++i)
+    std::cout << " " << TriggerTravelAnalyzer::bin_start(i) << ":" << stats.press_curve[i] << "/" << stats.release_curve[i];
+  std::cout << std::endl;
+
+  // presses start at 10%, releases end at 5%, the first value ever
+  // reported is the one at 5% on the way out
+  int press_value = -32767 + 10 * 65534 / 90;
+  int release_value = -32767 + 5 * 65534 / 90;
+  ok = ok && stats.presses == 100 && stats.releases == 100;
+  ok = ok && abs(stats.first_movement - release_value) <= 100;
+  ok = ok && stats.saturation == 32767 && stats.saturation_events > 100;
+  ok = ok && abs(analyzer.get_press_threshold(1) - press_value) < 50;
+  ok = ok && abs(analyzer.get_release_threshold(1) - release_value) < 50;
+  ok = ok && abs(analyzer.get_hysteresis(1) - (press_value - release_value)) < 100;
+  ok = ok && stats.press_curve[TriggerTravelAnalyzer::curve_size - 1] > 0;
+
+  // a reconnect in the middle of a press keeps what was measured and
+  // doesn't count the press twice, nor the jump back to rest
+  TriggerTravelAnalyzer::Stats before = stats;
+  analyzer.add(1, 0);
+  analyzer.resume(1, 1000);
+  analyzer.add(1, 2000);
+  analyzer.resume(1, -32767);
+  analyzer.add(1, -32767);
+  ok = ok && stats.presses == before.presses + 1 && stats.releases == before.releases &&
+    stats.rest == before.rest && stats.saturation == before.saturation;
+
+  // an axis that was never touched
+  const TriggerTravelAnalyzer::Stats& idle = analyzer.get_stats(0);
+  ok = ok && !idle.has_rest && idle.presses == 0 && analyzer.get_hysteresis(0) == 0;
+
+  std::cout << (ok ? "ok" : "WRONG") << std::endl;
+  return ok ? 0 : 1;
+}
+
+#endif
+
+/* EOF */
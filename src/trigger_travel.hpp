@@ -0,0 +1,104 @@
+/*
+**  jstest-gtk - A graphical joystick tester
+**  Copyright (C) 2025 Raphael Rosch <jstest-bugs@insaner.com>
+**
+**  This program is free software: you can redistribute it and/or modify
+**  it under the terms of the GNU General Public License as published by
+**  the Free Software Foundation, either version 3 of the License, or
+**  (at your option) any later version.
+**
+**  This program is distributed in the hope that it will be useful,
+**  but WITHOUT ANY WARRANTY; without even the implied warranty of
+**  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+**  GNU General Public License for more details.
+**
+**  You should have received a copy of the GNU General Public License
+**  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HEADER_JSTEST_GTK_TRIGGER_TRAVEL_HPP
+#define HEADER_JSTEST_GTK_TRIGGER_TRAVEL_HPP
+
+#include <stdint.h>
+#include <vector>
+
+/** Finds the usable travel of triggers, pedals and throttles from the
+    axis_move stream. Positions are measured from where the axis rests:
+    first movement is the reported value closest to rest, saturation
+    the one furthest away. A press starts when the axis leaves the rest
+    band and ends when it comes back, the values where that happens
+    give the press and release thresholds, their difference is the
+    hysteresis. The press and release curves count the events seen
+    while moving away from and back to rest, binned over the value
+    range, so a region only reported in one direction shows up as a gap
+    in the other curve. Memory is constant per axis. */
+class TriggerTravelAnalyzer
+{
+public:
+  // bin i covers values [-32768 + i * 65536 / curve_size, ...)
+  static const int curve_size = 32;
+
+  struct Stats
+  {
+    bool has_rest;
+    int rest;
+    int last;
+    bool pressed;
+
+    // valid once presses > 0
+    int first_movement;
+    int saturation;
+    uint32_t saturation_events; // events at the saturation value
+
+    uint32_t presses;
+    uint32_t releases;
+    int64_t press_sum;   // sum of the first values of each press
+    int64_t release_sum; // sum of the last values before each release
+
+    uint32_t press_curve[curve_size];
+    uint32_t release_curve[curve_size];
+  };
+
+private:
+  std::vector<Stats> m_axes;
+  int m_rest_band;
+
+public:
+  /** Values within \a rest_band of the rest value count as released */
+  TriggerTravelAnalyzer(int axis_count, int rest_band = 256);
+
+  void reset();
+
+  /** Sets where \a axis rests, axes at rest don't send events. Without
+      it the first value fed is taken as rest. */
+  void set_rest(int axis, int value);
+
+  /** Feed the axis_move stream, returns true when a press or release
+      completed or the travel of \a axis grew */
+  bool add(int axis, int value);
+
+  /** Takes \a value as the position of \a axis without counting the
+      move to it, for the initial state joydev reports when the device
+      is opened again. Rest and what was measured so far are kept. */
+  void resume(int axis, int value);
+
+  const Stats& get_stats(int axis) const { return m_axes[axis]; }
+  int get_axis_count() const { return static_cast<int>(m_axes.size()); }
+
+  /** Average values at which presses started and releases ended */
+  int get_press_threshold(int axis) const;
+  int get_release_threshold(int axis) const;
+
+  /** How much further from rest a press starts than a release ends */
+  int get_hysteresis(int axis) const;
+
+  static int get_bin(int value);
+  static int bin_start(int i) { return -32768 + i * (65536 / curve_size); }
+
+private:
+  void reset_axis(Stats& stats);
+};
+
+#endif
+
+/* EOF */
@@ -22,6 +22,25 @@
 #include <iostream>
 #include <stdexcept>
 
+std::string get_udev_stable_id(struct udev_device* dev)
+{
+  const char* serial       = udev_device_get_property_value(dev, "ID_SERIAL");
+  const char* serial_short = udev_device_get_property_value(dev, "ID_SERIAL_SHORT");
+  const char* path         = udev_device_get_property_value(dev, "ID_PATH");
+
+  // ID_SERIAL is only unique when it contains a real serial number,
+  // otherwise it is just vendor_model and identical for two pads of
+  // the same kind
+  if (serial && serial_short && *serial_short)
+    return std::string("serial:") + serial;
+  else if (path)
+    return std::string("path:") + path;
+  else if (serial)
+    return std::string("serial:") + serial;
+  else
+    return std::string();
+}
+
 UdevMonitor::UdevMonitor()
 {
   udev = udev_new();
@@ -78,8 +97,9 @@ bool UdevMonitor::on_io_event(Glib::IOCondition)
   if (dev) {
     const char* action = udev_device_get_action(dev);
     const char* devnode = udev_device_get_devnode(dev);
+    signal_uevent.emit(action ? action : "", udev_device_get_syspath(dev), udev_device_get_seqnum(dev));
     if (devnode && strstr(devnode, "/js")) {
-      signal_joystick_event.emit(action ? action : "", devnode);
+      signal_joystick_event.emit(action ? action : "", devnode, get_udev_stable_id(dev));
     }
     udev_device_unref(dev);
   }
@@ -24,12 +24,21 @@
 #include <string>
 #include <sigc++/signal.h>
 
+/** Identity of an input device that survives replugging and jsX
+    renumbering: the serial number when the device has one, the
+    physical port (ID_PATH) otherwise. Empty when udev knows neither. */
+std::string get_udev_stable_id(struct udev_device* dev);
+
 class UdevMonitor {
 public:
   UdevMonitor();
   ~UdevMonitor();
 
-  sigc::signal<void, std::string, std::string> signal_joystick_event;
+  /** action, devnode, stable id */
+  sigc::signal<void, std::string, std::string, std::string> signal_joystick_event;
+
+  /** action, syspath, SEQNUM; emitted for every input device event */
+  sigc::signal<void, std::string, std::string, unsigned long long> signal_uevent;
 
 private:
   struct udev* udev = nullptr;